@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+struct Result {
+    std::string name;
+    std::string params;
+    uint32_t samples;
+    uint32_t inner;
+    uint32_t bytes;
+    uint64_t minNs, medianNs, p90Ns, maxNs;
+    double meanNs;
+};
+
+struct Failure {
+    std::string name;
+    std::string reason;
+};
+
+std::vector<Result> results;
+std::vector<Failure> failures;
+}  // namespace
+
+void Bench::record(const char* name, const char* params, std::vector<uint64_t>& perCallNs,
+                   uint32_t inner, uint32_t bytes) {
+    if (perCallNs.empty()) return;
+    std::sort(perCallNs.begin(), perCallNs.end());
+
+    double sum = 0;
+    for (uint64_t ns : perCallNs) sum += (double)ns;
+
+    Result r;
+    r.name = name;
+    r.params = params;
+    r.samples = (uint32_t)perCallNs.size();
+    r.inner = inner;
+    r.bytes = bytes;
+    r.minNs = perCallNs.front();
+    r.medianNs = perCallNs[perCallNs.size() / 2];
+    r.p90Ns = perCallNs[perCallNs.size() * 9 / 10];
+    r.maxNs = perCallNs.back();
+    r.meanNs = sum / perCallNs.size();
+    results.push_back(r);
+
+    Serial.printf("[Bench] %-28s %-14s median %8llu ns  p90 %8llu ns\n", name, params,
+                  (unsigned long long)r.medianNs, (unsigned long long)r.p90Ns);
+}
+
+void Bench::fail(const char* name, const char* reason) {
+    failures.push_back({name, reason});
+    Serial.printf("[Bench] CHECK FAILED %s: %s\n", name, reason);
+}
+
+bool Bench::writeJSON(FILE* out) {
+    fprintf(out, "{\n  \"schema\": 1,\n  \"unit\": \"ns\",\n  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(out,
+                "%s\n    {\"name\": \"%s\", \"params\": \"%s\", \"samples\": %u, "
+                "\"inner\": %u, \"bytes\": %u, \"min\": %llu, \"median\": %llu, "
+                "\"p90\": %llu, \"max\": %llu, \"mean\": %.1f}",
+                i ? "," : "", r.name.c_str(), r.params.c_str(), r.samples, r.inner, r.bytes,
+                (unsigned long long)r.minNs, (unsigned long long)r.medianNs,
+                (unsigned long long)r.p90Ns, (unsigned long long)r.maxNs, r.meanNs);
+    }
+    fprintf(out, "\n  ],\n  \"failures\": [");
+    for (size_t i = 0; i < failures.size(); i++) {
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"reason\": \"%s\"}", i ? "," : "",
+                failures[i].name.c_str(), failures[i].reason.c_str());
+    }
+    fprintf(out, "%s]\n}\n", failures.empty() ? "" : "\n  ");
+    return failures.empty();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <chrono>
+#include <vector>
+
+/// Minimal timing harness for the host benchmarks.
+///
+/// Each benchmark takes `samples` timings of `inner` back-to-back calls and
+/// records the per-call distribution. Results are written as one JSON
+/// document so runs can be diffed by bench/compare.py.
+namespace Bench {
+    inline uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// Keeps Serial quiet for the lifetime of the object.
+    struct SerialMute {
+        SerialMute() { NativeHal::setSerialEnabled(false); }
+        ~SerialMute() { NativeHal::setSerialEnabled(true); }
+    };
+
+    /// Record a finished series. `bytes` is the output size per call, if any.
+    void record(const char* name, const char* params, std::vector<uint64_t>& perCallNs,
+                uint32_t inner, uint32_t bytes = 0);
+
+    /// Time `fn` and record it under `name`. Serial is muted while timing.
+    template <typename Fn>
+    void run(const char* name, const char* params, uint32_t samples, uint32_t inner, Fn fn,
+             uint32_t bytes = 0) {
+        std::vector<uint64_t> perCall;
+        perCall.reserve(samples);
+        {
+            SerialMute mute;
+            for (uint32_t s = 0; s < samples; s++) {
+                uint64_t t0 = nowNs();
+                for (uint32_t i = 0; i < inner; i++) fn();
+                perCall.push_back((nowNs() - t0) / inner);
+            }
+        }
+        record(name, params, perCall, inner, bytes);
+    }
+
+    /// Flag a failed sanity check; main() exits non-zero at the end.
+    void fail(const char* name, const char* reason);
+
+    /// Write all results as JSON to `out`. Returns false if any check failed.
+    bool writeJSON(FILE* out);
+
+    // ── Suites ───────────────────────────────────────────────────────────
+    void storageSuite();
+    void historySuite();
+    void sensorSuite();
+    void cloudSuite();
+    void jsonSuite();
+}
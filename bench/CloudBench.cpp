@@ -0,0 +1,34 @@
+#include "Bench.h"
+#include "CloudSync.h"
+#include "Config.h"
+#include "SettingsManager.h"
+
+static OutboxMgr::Entry samples[OUTBOX_REPLAY_BATCH];
+
+static char payload[CLOUD_PAYLOAD_MAX];
+
+static void payloadWith(const char* params, uint16_t count) {
+    static uint16_t n;
+    n = count;
+    size_t len = CloudSync::buildPushPayload(payload, sizeof(payload), 123.4f, 100.0f, 50.0f,
+                                             "NORMAL", samples, n);
+    if (len == 0) Bench::fail("cloud.buildPushPayload", "payload outgrew CLOUD_PAYLOAD_MAX");
+    Bench::run("cloud.buildPushPayload", params, 200, 20, [] {
+        CloudSync::buildPushPayload(payload, sizeof(payload), 123.4f, 100.0f, 50.0f, "NORMAL",
+                                    samples, n);
+    }, len);
+}
+
+void Bench::cloudSuite() {
+    SettingsMgr::begin();
+
+    uint32_t epoch = 1700000000UL;
+    for (int i = 0; i < OUTBOX_REPLAY_BATCH; i++) {
+        samples[i].epoch = epoch += LOG_INTERVAL_MS / 1000;
+        samples[i].tenths = 1234 + (i % 5) - 2;
+    }
+
+    payloadWith("batch=0", 0);
+    payloadWith("batch=10", CLOUD_BATCH_SIZE);
+    payloadWith("batch=30", OUTBOX_REPLAY_BATCH);
+}
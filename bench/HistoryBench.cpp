@@ -0,0 +1,79 @@
+#include "Bench.h"
+#include "Config.h"
+#include "StorageManager.h"
+#include <LittleFS.h>
+
+/// Print sink that only counts, standing in for AsyncResponseStream.
+class CountingPrint : public Print {
+public:
+    size_t write(uint8_t) override { return ++bytes, 1; }
+    size_t write(const uint8_t*, size_t size) override { return bytes += size, size; }
+    using Print::write;
+    size_t bytes = 0;
+};
+
+void Bench::historySuite() {
+    {
+        SerialMute mute;
+        LittleFS.format();
+        StorageMgr::begin();
+        uint32_t epoch = 1700000000UL;
+        for (int i = 0; i < HISTORY_RING_CAPACITY; i++) {
+            StorageMgr::logReading(epoch += LOG_INTERVAL_MS / 1000, 100.0f + (i % 40) * 0.3f);
+        }
+    }
+
+    // Downsampling keeps the highest water of each group: i % 40 == 0
+    // readings (100.0 cm) must survive a 10-point limit
+    StorageMgr::Reading first, last;
+    StorageMgr::getReading(0, first);
+    StorageMgr::getReading(HISTORY_RING_CAPACITY - 1, last);
+    {
+        StorageMgr::HistoryStream stream(false, first.epoch, last.epoch, 10);
+        char out[512];
+        size_t n = 0, got;
+        while ((got = stream.read((uint8_t*)out + n, 7)) > 0 && n < sizeof(out) - 8)
+            n += got;
+        out[n] = 0;
+        if (!strstr(out, ",100.0\n") || stream.stride() != (HISTORY_RING_CAPACITY + 9) / 10)
+            fail("history.range", "downsampled range lost the peak");
+    }
+
+    static uint32_t probeEpoch = first.epoch + (last.epoch - first.epoch) / 3;
+    int probeIndex = StorageMgr::findFirstAtOrAfter(probeEpoch);
+    StorageMgr::Reading found, before;
+    if (!StorageMgr::getReading(probeIndex, found) || found.epoch < probeEpoch ||
+        (probeIndex > 0 && StorageMgr::getReading(probeIndex - 1, before) &&
+         before.epoch >= probeEpoch))
+        fail("history.find", "not the first reading at or after the epoch");
+    Bench::run("history.find", "entries=144", 500, 1, [] {
+        StorageMgr::findFirstAtOrAfter(probeEpoch);
+    });
+
+    static uint32_t rangeFrom = first.epoch + (last.epoch - first.epoch) / 4;
+    static uint32_t rangeTo = last.epoch - (last.epoch - first.epoch) / 4;
+    Bench::run("history.range", "half,limit=24", 200, 1, [] {
+        StorageMgr::HistoryStream stream(true, rangeFrom, rangeTo, 24);
+        uint8_t buf[256];
+        while (stream.read(buf, sizeof(buf)) > 0) {
+        }
+    });
+
+    CountingPrint probe;
+    StorageMgr::writeJSON(probe);
+    size_t jsonBytes = probe.bytes;
+    if (jsonBytes < (size_t)HISTORY_RING_CAPACITY * 20)
+        fail("history.json", "response shorter than the stored history");
+
+    Bench::run("history.json", "entries=144", 200, 1, [] {
+        CountingPrint sink;
+        StorageMgr::writeJSON(sink);
+    }, (uint32_t)jsonBytes);
+
+    CountingPrint csvProbe;
+    StorageMgr::writeCSV(csvProbe);
+    Bench::run("history.csv", "entries=144", 200, 1, [] {
+        CountingPrint sink;
+        StorageMgr::writeCSV(sink);
+    }, (uint32_t)csvProbe.bytes);
+}
@@ -0,0 +1,186 @@
+#include "Bench.h"
+#include "CloudSync.h"
+#include "Config.h"
+#include "LivePayload.h"
+#include "SettingsManager.h"
+#include <ArduinoJson.h>
+
+// Each fixed-schema payload is timed twice: through LivePayload/CloudSync
+// (JsonWriter into a caller buffer) and through the JsonDocument + String
+// path those writers replaced, kept here as the reference.
+
+/// Heap bytes an ArduinoJson document takes, via its allocator hook. The
+/// reference path is timed with it too; it is a thin wrapper over malloc
+/// like ArduinoJson's default allocator.
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        size_t* p = (size_t*)malloc(sizeof(size_t) + size);
+        if (!p) return nullptr;
+        *p = size;
+        grow(size);
+        return p + 1;
+    }
+    void deallocate(void* ptr) override {
+        if (!ptr) return;
+        size_t* p = (size_t*)ptr - 1;
+        live -= *p;
+        free(p);
+    }
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (!ptr) return allocate(newSize);
+        size_t* p = (size_t*)ptr - 1;
+        size_t old = *p;
+        p = (size_t*)realloc(p, sizeof(size_t) + newSize);
+        if (!p) return nullptr;
+        *p = newSize;
+        live -= old;
+        grow(newSize);
+        return p + 1;
+    }
+    void grow(size_t size) {
+        live += size;
+        if (live > peak) peak = live;
+    }
+    size_t live = 0;
+    size_t peak = 0;
+};
+
+static CountingAllocator counting;
+static LivePayload::Snapshot snap;
+static OutboxMgr::Entry samples[OUTBOX_REPLAY_BATCH];
+static char out[CLOUD_PAYLOAD_MAX];
+
+// ── Reference: the ArduinoJson path ─────────────────────────────────────────
+
+static String statusDoc(ArduinoJson::Allocator* alloc) {
+    JsonDocument doc(alloc);
+    doc["distance"] = snap.distance10 / 10.0f;
+    doc["warning"] = snap.warning10 / 10.0f;
+    doc["alarm"] = snap.alarm10 / 10.0f;
+    doc["rainExpected"] = snap.rainExpected;
+    doc["forecast"] = snap.forecast;
+    doc["entries"] = 144;
+    doc["station"] = snap.station;
+    doc["river"] = snap.river;
+    doc["interval"] = snap.interval;
+    doc["confidence"] = 97;
+    doc["status"] = snap.status;
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+static size_t frameDoc(ArduinoJson::Allocator* alloc) {
+    JsonDocument doc(alloc);
+    doc["type"] = "full";
+    doc["distance"] = snap.distance10 / 10.0f;
+    doc["warning"] = snap.warning10 / 10.0f;
+    doc["alarm"] = snap.alarm10 / 10.0f;
+    doc["rainExpected"] = snap.rainExpected;
+    doc["forecast"] = snap.forecast;
+    doc["station"] = snap.station;
+    doc["river"] = snap.river;
+    doc["interval"] = snap.interval;
+    doc["status"] = snap.status;
+    size_t len = measureJson(doc);
+    serializeJson(doc, out, len + 1);
+    return len;
+}
+
+static String pushDoc(ArduinoJson::Allocator* alloc) {
+    JsonDocument doc(alloc);
+    doc["distance"] = 123.4f;
+    doc["warning"] = 30.0f;
+    doc["alarm"] = 15.0f;
+    doc["status"] = "NORMAL";
+    doc["station"] = SettingsMgr::station();
+    doc["river"] = SettingsMgr::river();
+    JsonObject b = doc["batch"].to<JsonObject>();
+    b["t0"] = samples[0].epoch;
+    b["v0"] = samples[0].tenths;
+    b["scale"] = 10;
+    JsonArray dt = b["dt"].to<JsonArray>();
+    JsonArray dv = b["dv"].to<JsonArray>();
+    for (uint16_t i = 1; i < OUTBOX_REPLAY_BATCH; i++) {
+        dt.add((int32_t)(samples[i].epoch - samples[i - 1].epoch));
+        dv.add(samples[i].tenths - samples[i - 1].tenths);
+    }
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+/// Peak heap of one reference call, counting its output String.
+template <typename Fn>
+static void reportHeap(const char* name, Fn fn) {
+    counting.peak = 0;
+    size_t outBytes = fn(&counting);
+    Serial.printf("[Bench] %-28s heap peak %u B via ArduinoJson, 0 B via JsonWriter\n", name,
+                  (unsigned)(counting.peak + outBytes));
+}
+
+void Bench::jsonSuite() {
+    {
+        SerialMute mute;
+        SettingsMgr::begin();
+    }
+    snap.distance10 = 1234;
+    snap.warning10 = 300;
+    snap.alarm10 = 150;
+    snap.rainExpected = false;
+    snap.interval = 60;
+    snap.status = "NORMAL";
+    LivePayload::setText(snap, "light rain");
+
+    uint32_t epoch = 1700000000UL;
+    for (int i = 0; i < OUTBOX_REPLAY_BATCH; i++) {
+        samples[i].epoch = epoch += LOG_INTERVAL_MS / 1000;
+        samples[i].tenths = 1234 + (i % 5) - 2;
+    }
+
+    // The writers must produce exactly the documented schema
+    LivePayload::writeStatus(out, sizeof(out), snap, 144, 97);
+    if (strcmp(out, "{\"distance\":123.4,\"warning\":30,\"alarm\":15,\"rainExpected\":false,"
+                    "\"forecast\":\"light rain\",\"entries\":144,\"station\":\"Antwerpen\","
+                    "\"river\":\"Schelde\",\"interval\":60,\"confidence\":97,"
+                    "\"status\":\"NORMAL\"}") != 0)
+        fail("json.status", "writer output differs from the /api/status schema");
+    LivePayload::Snapshot prev = snap;
+    prev.distance10 = 1240;
+    LivePayload::writeFrame(out, sizeof(out), snap, &prev);
+    if (strcmp(out, "{\"type\":\"delta\",\"distance\":123.4}") != 0)
+        fail("json.frame", "delta frame carries more than the changed field");
+
+    static size_t len;
+    len = LivePayload::writeStatus(out, sizeof(out), snap, 144, 97);
+    run("json.status", "arduinojson", 200, 50, [] { statusDoc(&counting); }, len);
+    run("json.status", "writer", 200, 50,
+        [] { LivePayload::writeStatus(out, sizeof(out), snap, 144, 97); }, len);
+    reportHeap("json.status", [](ArduinoJson::Allocator* a) {
+        return statusDoc(a).length() + 1;
+    });
+
+    len = LivePayload::writeFrame(out, sizeof(out), snap, nullptr);
+    run("json.frame", "full,arduinojson", 200, 50, [] { frameDoc(&counting); }, len);
+    run("json.frame", "full,writer", 200, 50,
+        [] { LivePayload::writeFrame(out, sizeof(out), snap, nullptr); }, len);
+    reportHeap("json.frame", [](ArduinoJson::Allocator* a) {
+        frameDoc(a);
+        return (size_t)0; // serialized into the caller's buffer
+    });
+
+    {
+        SerialMute mute;
+        len = CloudSync::buildPushPayload(out, sizeof(out), 123.4f, 30.0f, 15.0f, "NORMAL",
+                                          samples, OUTBOX_REPLAY_BATCH);
+    }
+    run("json.push", "batch=30,arduinojson", 200, 20, [] { pushDoc(&counting); }, len);
+    run("json.push", "batch=30,writer", 200, 20, [] {
+        CloudSync::buildPushPayload(out, sizeof(out), 123.4f, 30.0f, 15.0f, "NORMAL", samples,
+                                    OUTBOX_REPLAY_BATCH);
+    }, len);
+    reportHeap("json.push", [](ArduinoJson::Allocator* a) {
+        return pushDoc(a).length() + 1;
+    });
+}
@@ -0,0 +1,108 @@
+#include "Bench.h"
+#include "Config.h"
+#include "SensorFilter.h"
+#include "SensorManager.h"
+#include <math.h>
+
+static const float TRUE_DISTANCE_CM = 87.5f;
+
+/// Track a level moving at `rateCmPerS` (negative: rising water) with one
+/// tick every `intervalMs`, the way SensorMgr drives the filter: a missed
+/// or rejected ping is followed by confirmation pings PING_GAP_MS apart.
+/// Every fifth tick loses its first echo; ±1 cm noise, 5 % wild echoes.
+static void trackScenario(const char* params, unsigned long intervalMs, float rateCmPerS) {
+    static const unsigned long PING_GAP_MS = 60;
+    SensorFilter f;
+    unsigned long t = 0;
+    float truth = TRUE_DISTANCE_CM, worstCm = 0, worstRate = 0;
+    uint32_t confirms = 0;
+    srand(7);
+    for (unsigned tick = 0; tick < 100; tick++) {
+        t += intervalMs;
+        truth = TRUE_DISTANCE_CM + rateCmPerS * (t / 1000.0f);
+        bool dropFirst = tick % 5 == 0;
+        for (uint8_t left = SENSOR_CONFIRM_PINGS;; left--) {
+            float ping = rand() % 20 == 0 ? 20.0f + rand() % 300
+                                          : truth + (rand() % 200 - 100) * 0.01f;
+            if (dropFirst) {
+                ping = -1.0f;
+                dropFirst = false;
+            }
+            if (f.update(t, ping) == SensorFilter::PING_ACCEPTED || left == 0) break;
+            t += PING_GAP_MS;
+            confirms++;
+        }
+        if (tick < 20) continue; // let the tracker settle
+        worstCm = fmaxf(worstCm, fabsf(f.estimate().distanceCm - truth));
+        worstRate = fmaxf(worstRate, fabsf(f.estimate().rateCmPerS - rateCmPerS));
+    }
+    Serial.printf("[Bench] sensor.track %-18s worst error %.2f cm, %.4f cm/s "
+                  "(%u confirmation pings)\n",
+                  params, worstCm, worstRate, (unsigned)confirms);
+    // The level error allowed is what the worst rate error adds over one tick
+    if (worstCm > 3.0f || worstRate * intervalMs / 1000.0f > 3.0f)
+        Bench::fail("sensor.track", "confirmation pings skewed the tracked rate");
+}
+
+void Bench::sensorSuite() {
+    trackScenario("interval=2s", 2000, 0.0f);
+    trackScenario("interval=2s,rising", 2000, -0.01f);
+    trackScenario("interval=300s", 300000, 0.0f);
+    trackScenario("interval=300s,rising", 300000, -0.001f); // 30 cm over the run
+
+    // Pre-generated noisy bursts, so the timing excludes rand()
+    static float pool[256][5];
+    srand(42);
+    for (auto& burst : pool) {
+        for (float& v : burst) v = TRUE_DISTANCE_CM + (rand() % 200 - 100) * 0.05f;
+    }
+
+    static unsigned cursor = 0;
+    static volatile float sinkCm = 0;
+    Bench::run("sensor.median", "n=5", 200, 1000, [] {
+        float values[5];
+        memcpy(values, pool[cursor++ & 255], sizeof(values));
+        sinkCm = SensorMgr::median(values, 5);
+    });
+    if (fabsf(sinkCm - TRUE_DISTANCE_CM) > 5.0f)
+        fail("sensor.median", "median left the noise band");
+
+    // Streaming filter: one noisy ping per tick with 5 % wild echoes (the
+    // tank wall, splashes). Timed per update; checked against the truth.
+    static float stream[1024];
+    for (unsigned i = 0; i < 1024; i++) {
+        stream[i] = rand() % 20 == 0 ? 20.0f + rand() % 300
+                                     : TRUE_DISTANCE_CM + (rand() % 200 - 100) * 0.05f;
+    }
+    static SensorFilter filter;
+    static unsigned long tickMs = 0;
+    Bench::run("sensor.filterUpdate", "outliers=5%", 200, 1000, [] {
+        filter.update(tickMs += 2000, stream[cursor++ & 1023]);
+    });
+    if (fabsf(filter.estimate().distanceCm - TRUE_DISTANCE_CM) > 2.5f)
+        fail("sensor.filterUpdate", "estimate left the noise band despite outliers");
+    // ±5 cm of noise scales the confidence to ~0.4; outliers take a little more
+    if (filter.estimate().confidence < 0.25f)
+        fail("sensor.filterUpdate", "confidence collapsed on a usable signal");
+
+    NativeHal::setEcho(PIN_TRIG, PIN_ECHO, TRUE_DISTANCE_CM);
+    SensorMgr::begin();
+
+    static float lastCm = -1;
+    const char* pings = SENSOR_STREAM_FILTER ? "pings=1" : "pings=5";
+    Bench::run("sensor.readBlocking", pings, 200, 1,
+               [] { lastCm = SensorMgr::readDistanceCm(); });
+    if (fabsf(lastCm - TRUE_DISTANCE_CM) > 0.5f)
+        fail("sensor.readBlocking", "reading does not match the simulated echo");
+
+    // Async burst: CPU time spent in poll() across one full burst, with the
+    // virtual clock stepping over the ping gaps
+    Bench::run("sensor.asyncBurst", pings, 200, 1, [] {
+        SensorMgr::requestReading();
+        float cm;
+        while (!SensorMgr::poll(cm)) NativeHal::advanceMicros(5000);
+        lastCm = cm;
+    });
+    if (fabsf(lastCm - TRUE_DISTANCE_CM) > 0.5f)
+        fail("sensor.asyncBurst", "reading does not match the simulated echo");
+}
@@ -0,0 +1,195 @@
+#include "Bench.h"
+#include "Config.h"
+#include "OutboxManager.h"
+#include "RingFile.h"
+#include "RollupManager.h"
+#include "StorageManager.h"
+#include <LittleFS.h>
+
+static const uint32_t LOG_STEP_S = LOG_INTERVAL_MS / 1000;
+static uint32_t nextEpoch = 1700000000UL; // kept monotonic across rounds
+
+/// Wipe the filesystem and log `fill` readings so the ring starts that full.
+static void freshStore(uint32_t fill) {
+    Bench::SerialMute mute;
+    LittleFS.format();
+    StorageMgr::begin();
+    for (uint32_t i = 0; i < fill; i++) {
+        StorageMgr::logReading(nextEpoch += LOG_STEP_S, 120.0f + (i % 7) * 0.5f);
+    }
+}
+
+/// Time `ops` appends starting from a ring holding `fill` readings.
+static void logAtFill(const char* params, uint32_t fill, uint32_t ops, uint32_t rounds) {
+    std::vector<uint64_t> perCall;
+    perCall.reserve(ops * rounds);
+    uint64_t programmed = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        freshStore(fill);
+        Bench::SerialMute mute;
+        uint64_t before = NativeHal::fsProgrammedBytes();
+        for (uint32_t i = 0; i < ops; i++) {
+            uint64_t t0 = Bench::nowNs();
+            StorageMgr::logReading(nextEpoch += LOG_STEP_S, 118.5f);
+            perCall.push_back(Bench::nowNs() - t0);
+        }
+        programmed += NativeHal::fsProgrammedBytes() - before;
+    }
+    Bench::record("storage.logReading", params, perCall, 1);
+    Serial.printf("[Bench] storage.logReading %-10s %8.1f B programmed per reading\n", params,
+                  (double)programmed / (ops * rounds));
+}
+
+/// The open rollup buckets live in RAM; a reboot must rebuild them.
+static void rollupReplayCheck() {
+    RollupMgr::Bucket before[RollupMgr::RESOLUTION_COUNT], after;
+    for (uint8_t res = 0; res < RollupMgr::RESOLUTION_COUNT; res++) {
+        RollupMgr::Resolution r = (RollupMgr::Resolution)res;
+        RollupMgr::getBucket(r, RollupMgr::getBucketCount(r) - 1, before[res]);
+    }
+    {
+        Bench::SerialMute mute;
+        StorageMgr::begin();
+    }
+    for (uint8_t res = 0; res < RollupMgr::RESOLUTION_COUNT; res++) {
+        RollupMgr::Resolution r = (RollupMgr::Resolution)res;
+        if (!RollupMgr::getBucket(r, RollupMgr::getBucketCount(r) - 1, after) ||
+            after.start != before[res].start || after.count != before[res].count ||
+            fabsf(after.mean - before[res].mean) > 0.05f)
+            Bench::fail("storage.logReading", "open rollup bucket not rebuilt after reboot");
+    }
+}
+
+/// Flash bytes LittleFS programs per RingFile append once the ring has
+/// wrapped, appending `batch` records per call.
+static void ringFlashPerAppend(const char* params, uint16_t recordSize, uint32_t capacity,
+                               uint32_t batch, uint16_t segmentBytes = RING_SEGMENT_BYTES) {
+    Bench::SerialMute mute;
+    LittleFS.format();
+    RingFile ring("/bench.bin", recordSize, capacity, segmentBytes);
+    ring.begin();
+    std::vector<uint8_t> recs(recordSize * batch);
+    for (uint32_t i = 0; i < capacity; i += batch) ring.appendMany(recs.data(), batch);
+
+    uint32_t appends = capacity * 2;
+    uint64_t before = NativeHal::fsProgrammedBytes();
+    for (uint32_t i = 0; i < appends; i += batch) ring.appendMany(recs.data(), batch);
+    double perRecord = (double)(NativeHal::fsProgrammedBytes() - before) / appends;
+    NativeHal::setSerialEnabled(true);
+    Serial.printf("[Bench] %-28s %8.1f B programmed per record (%u B record)\n", params,
+                  perRecord, (unsigned)recordSize);
+    if (perRecord > segmentBytes)
+        Bench::fail("ring.append", "an append rewrote more than its segment");
+}
+
+/// Outbox: queue a backlog in replay-sized batches, then drain it the way
+/// CloudSync does (peek, ack, pop).
+static void outboxFlash() {
+    static const uint16_t batch = OUTBOX_REPLAY_BATCH;
+    OutboxMgr::Entry e[batch];
+    uint64_t pushed = 0, popped = 0;
+    {
+        Bench::SerialMute mute;
+        LittleFS.format();
+        OutboxMgr::begin();
+        for (uint32_t n = 0; n < OUTBOX_CAPACITY / 2; n += batch) {
+            for (uint16_t i = 0; i < batch; i++) e[i] = {nextEpoch += LOG_STEP_S, 1185};
+            uint64_t before = NativeHal::fsProgrammedBytes();
+            OutboxMgr::push(e, batch);
+            pushed += NativeHal::fsProgrammedBytes() - before;
+        }
+        while (OutboxMgr::depth() > 0) {
+            uint16_t n = OutboxMgr::peek(e, batch);
+            uint64_t before = NativeHal::fsProgrammedBytes();
+            OutboxMgr::pop(n);
+            popped += NativeHal::fsProgrammedBytes() - before;
+        }
+        OutboxMgr::begin(); // reboot: the drained state must have been saved
+    }
+    uint32_t readings = OUTBOX_CAPACITY / 2 / batch * batch;
+    Serial.printf("[Bench] outbox batch=%-16u %8.1f B programmed per queued reading, "
+                  "%.2f per acked reading\n",
+                  (unsigned)batch, (double)pushed / readings, (double)popped / readings);
+    if (OutboxMgr::depth() != 0)
+        Bench::fail("outbox.pop", "drained outbox came back after a reboot");
+}
+
+/// Sequence numbers, wrap-around, the persisted tail and a reboot.
+static void ringChecks() {
+    Bench::SerialMute mute;
+    LittleFS.format();
+    {
+        RingFile ring("/check.bin", sizeof(uint32_t), 100);
+        ring.begin();
+        for (uint32_t i = 0; i < 250; i++) ring.append(&i);
+        ring.dropOldest(10);
+    }
+    RingFile ring("/check.bin", sizeof(uint32_t), 100);
+    ring.begin();
+    uint32_t first = 0, last = 0;
+    if (ring.total() != 250 || ring.count() != 90 || !ring.read(0, &first) || first != 160 ||
+        !ring.read(89, &last) || last != 249)
+        Bench::fail("ring.append", "ring lost its head or tail across a reboot");
+    ring.clear();
+    uint32_t v = 7;
+    ring.append(&v);
+    if (ring.count() != 1 || ring.total() != 251 || !ring.read(0, &first) || first != 7)
+        Bench::fail("ring.append", "append after clear() misplaced the record");
+}
+
+void Bench::storageSuite() {
+    ringChecks();
+    outboxFlash();
+    ringFlashPerAppend("ring.history", sizeof(StorageMgr::Reading), HISTORY_RING_CAPACITY, 1);
+    ringFlashPerAppend("ring.outbox", 8, OUTBOX_CAPACITY, 1);
+    ringFlashPerAppend("ring.rollup_minute", 24, ROLLUP_MINUTE_CAPACITY, 1);
+
+
+    const uint32_t cap = HISTORY_RING_CAPACITY;
+    logAtFill("fill=0%", 0, cap / 4, 20);
+    logAtFill("fill=50%", cap / 2, cap / 4, 20);
+    logAtFill("fill=100%", cap, cap, 20); // every append overwrites the oldest
+
+    if (StorageMgr::getEntryCount() != (int)cap)
+        fail("storage.logReading", "ring count drifted from its capacity");
+    {
+        SerialMute mute;
+        uint32_t before = StorageMgr::cursor();
+        StorageMgr::logReading(42, 118.5f);                    // NTP not synced
+        StorageMgr::logReading(nextEpoch - 3600, 118.5f);      // clock stepped back
+        if (StorageMgr::cursor() != before)
+            fail("storage.logReading", "logged a reading out of time order");
+    }
+    rollupReplayCheck();
+
+    // Archive: 30 days of one-minute readings, then decode one day of it
+    static const uint32_t days = 30, perDay = 1440;
+    static uint32_t dayStart;
+    freshStore(0);
+    uint64_t before = NativeHal::fsProgrammedBytes();
+    {
+        SerialMute mute;
+        for (uint32_t i = 0; i < days * perDay; i++) {
+            if (i == (days - 1) * perDay)
+                dayStart = nextEpoch + LOG_STEP_S;
+            ArchiveMgr::addReading(nextEpoch += LOG_STEP_S, 120.0f + (i % 90) * 0.1f);
+        }
+    }
+    ArchiveMgr::Stats s = ArchiveMgr::getStats();
+    Serial.printf("[Bench] archive days=%-19u %8.1f B programmed per reading, "
+                  "%.0f per block (%.1f readings per block)\n",
+                  (unsigned)days, (double)(NativeHal::fsProgrammedBytes() - before) / s.readings,
+                  (double)(NativeHal::fsProgrammedBytes() - before) / s.blocks,
+                  (double)s.readings / s.blocks);
+    if (s.readings != days * perDay || s.bytesPerReading > 3.0f)
+        fail("archive.read", "archive lost readings or stopped compressing");
+    Bench::run("archive.read", "day=1440", 50, 1, [] {
+        ArchiveMgr::Reader r(dayStart, dayStart + (perDay - 1) * LOG_STEP_S);
+        uint32_t epoch, n = 0;
+        float cm;
+        while (r.next(epoch, cm))
+            n++;
+        if (n != perDay)
+            fail("archive.read", "day range returned the wrong number of readings");
+    });
+}
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Compare two host benchmark reports and fail on regressions.
+
+    python bench/compare.py baseline.json current.json [--tolerance 0.15]
+
+A result regresses when its median grows by more than the tolerance
+(default 15 %) over the baseline. Exit code 1 on any regression or on a
+failed sanity check in the current report.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return report, {(r["name"], r["params"]): r for r in report["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=0.15)
+    args = parser.parse_args()
+
+    _, base = load(args.baseline)
+    report, cur = load(args.current)
+
+    regressions = 0
+    for key, r in sorted(cur.items()):
+        name = "%s [%s]" % key
+        if key not in base:
+            print("  new   %-44s %10d ns" % (name, r["median"]))
+            continue
+        before = base[key]["median"]
+        change = (r["median"] - before) / before if before else 0.0
+        flag = "ok"
+        if change > args.tolerance:
+            flag = "SLOW"
+            regressions += 1
+        print("  %-5s %-44s %10d -> %10d ns  %+6.1f%%"
+              % (flag, name, before, r["median"], change * 100))
+
+    for f in report.get("failures", []):
+        print("  FAIL  %s: %s" % (f["name"], f["reason"]))
+
+    if regressions or report.get("failures"):
+        print("%d regression(s), %d failed check(s)"
+              % (regressions, len(report.get("failures", []))))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
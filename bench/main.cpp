@@ -0,0 +1,30 @@
+// Host benchmark runner: pio run -e native -t exec
+// Log lines go to stderr, the JSON report to stdout (or to argv[1]).
+#include "Bench.h"
+#include <filesystem>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    // Fresh scratch filesystem per run so fill levels are reproducible
+    std::filesystem::path root =
+        std::filesystem::temp_directory_path() / ("floodbench-" + std::to_string(getpid()));
+    NativeHal::setFsRoot(root.c_str());
+
+    Bench::storageSuite();
+    Bench::historySuite();
+    Bench::sensorSuite();
+    Bench::cloudSuite();
+    Bench::jsonSuite();
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    FILE* out = argc > 1 ? fopen(argv[1], "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "[Bench] Cannot write %s\n", argv[1]);
+        return 2;
+    }
+    bool ok = Bench::writeJSON(out);
+    if (out != stdout) fclose(out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+
+/// Long-term history: every logged reading, compressed into fixed-size
+/// blocks kept in a RingFile on LittleFS.
+///
+/// A block stores its first reading in full and the rest as zigzag varints:
+/// the timestamp as delta-of-delta (one byte while the log interval holds)
+/// and the level as the change in 0.1 cm since the previous reading. A
+/// steady log costs about 2 bytes per reading instead of 8 in the raw ring.
+///
+/// The block being filled lives in RAM and is appended once, when full.
+/// Every block carries its own sequence number, so a block recycled while
+/// a reader held its number is detected rather than decoded. After a reboot
+/// the open block is replayed from the raw history ring, which always holds
+/// more readings than one block can.
+namespace ArchiveMgr {
+    struct Stats {
+        uint32_t readings;       // readings archived (incl. the open block)
+        uint32_t blocks;         // blocks on flash
+        uint32_t capacity;       // blocks the file can hold
+        uint32_t oldestEpoch;    // 0 while empty
+        uint32_t bytes;          // flash used by blocks, plus the open block
+        float bytesPerReading;
+    };
+
+    /// Open the archive and catch up from the raw ring.
+    /// Call once the history ring is open.
+    void begin();
+
+    /// Append one reading. Readings older than the last one are skipped so
+    /// the archive stays sorted by time.
+    void addReading(uint32_t epoch, float distanceCm);
+
+    /// Epoch of the oldest archived reading, 0 if the archive is empty.
+    uint32_t oldestEpoch();
+
+    Stats getStats();
+
+    /// Sequential reader over the archived readings with `from` <= epoch
+    /// <= `to`. Both ends are found by binary search over block headers,
+    /// then decoded a reading at a time straight from flash.
+    class Reader {
+    public:
+        Reader(uint32_t from = 0, uint32_t to = UINT32_MAX);
+
+        /// Decode the next reading in range; false once past the end.
+        bool next(uint32_t& epoch, float& distanceCm);
+
+        /// Readings left before the end of the range.
+        uint32_t remaining() const {
+            return _valid && _endSeq > _seq ? _endSeq - _seq : 0;
+        }
+
+    private:
+        bool load(uint32_t block);
+        bool advance();
+
+        bool _valid = false;
+        uint32_t _block = 0;   // block sequence number being decoded
+        uint32_t _seq = 0;     // reading sequence number of the current one
+        uint32_t _endSeq = 0;  // one past the range
+        uint32_t _epoch = 0;   // current reading
+        int32_t _deci = 0;     // current level in 0.1 cm
+        int32_t _delta = 0;    // last timestamp delta
+        uint16_t _offset = 0;  // payload offset of the following reading
+        uint16_t _used = 0;    // payload bytes of the block when loaded
+        uint16_t _left = 0;    // readings after the current one in the block
+    };
+}
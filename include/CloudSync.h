@@ -1,6 +1,11 @@
 #pragma once
 #include <Arduino.h>
+#include "OutboxManager.h"
 
+/// Asynchronous uplink to the Netlify functions.
+///
+/// Requests are queued and driven by a small state machine advanced from
+/// loop() via CloudSync::loop(); the caller never waits on the network.
 namespace CloudSync {
     struct CloudConfig {
         int32_t nextIntervalS = -1;
@@ -9,25 +14,71 @@ namespace CloudSync {
         bool success = false;
     };
 
+    /// Called from CloudSync::loop() when a push response has been parsed.
+    typedef void (*ConfigCallback)(const CloudConfig& config);
+
+    /**
+     * @brief Register the handler that receives the server's CloudConfig.
+     */
+    void onConfig(ConfigCallback callback);
+
+    /// Called when a push or migration is queued, so the caller can
+    /// schedule loop() again.
+    typedef void (*WakeCallback)();
+    void onWake(WakeCallback callback);
+
     /**
-     * @brief Pushes current sensor data to Netlify. Cloud fetches weather independently.
+     * @brief Queues a status push to Netlify. Cloud fetches weather independently.
+     *
+     * Pushes coalesce: a push that is still queued is replaced by the newer
+     * values, and a push identical to the one in flight is not queued again.
+     * The reading itself always joins the batch.
+     *
+     * Every call also records the reading. Readings are sent together as
+     * one delta-encoded batch once CLOUD_BATCH_SIZE have accumulated or the
+     * batch is CLOUD_BATCH_MAX_AGE_MS old. A status change, any ALARM
+     * reading or `flushNow` sends immediately. Readings that can't be
+     * delivered are kept in the OutboxMgr queue and replayed oldest-first.
      * @param distance Measured water level (cm)
      * @param warnThr Current warning threshold
      * @param alarmThr Current alarm threshold
      * @param status Current status string (NORMAL, WARNING, ALARM)
-     * @return CloudConfig containing updated settings from server
+     * @param flushNow Send without waiting for the batch to fill
      */
-    CloudConfig pushData(float distance, float warnThr, float alarmThr, const String& status);
-
+    void requestPush(float distance, float warnThr, float alarmThr, const char* status,
+                     bool flushNow = false);
 
     /**
-     * @brief Triggers a station migration on the server (rename/move data).
-     * 
+     * @brief Queues a station migration on the server (rename/move data).
+     *
      * @param oldName The previous station name
      * @param newName The new station name
      * @param river The river name
-     * @return true if migration triggered successfully
      */
-    bool migrateStation(const String& oldName, const String& newName, const String& river);
+    void requestMigration(const String& oldName, const String& newName, const String& river);
+
+    /**
+     * @brief Advance the outbound request state machine. Call every loop.
+     */
+    void loop();
+
+    /// True while a request is queued or in flight.
+    bool isBusy();
+
+    /// Milliseconds until loop() has something to do: 0 while a request is
+    /// in flight or ready, the wait for a partial batch, the replay pacing
+    /// or the link otherwise, -1 when nothing is pending.
+    int32_t nextStepMs();
+
+    /// Move readings still waiting for a batch to the outbox, e.g. before
+    /// deep sleep, so they survive and are replayed later.
+    void stash();
 
+    /// Serialise a status push into `buf`, with `count` readings
+    /// delta-encoded as its batch. Returns the JSON length, or 0 if it needs
+    /// more than `size` - 1 bytes. Used by requestPush(); public so the host
+    /// benchmarks can time it.
+    size_t buildPushPayload(char* buf, size_t size, float distance, float warnThr,
+                            float alarmThr, const char* status,
+                            const OutboxMgr::Entry* samples, uint16_t count);
 }
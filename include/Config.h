@@ -11,12 +11,43 @@
 #define DEFAULT_ALARM_CM     15.0f   // Alarm threshold (critical)
 #define RAIN_THRESHOLD_FACTOR 0.8f   // Multiply thresholds by this when rain expected
 
+// ─── Sensor Acquisition ─────────────────────────────────────────────────────
+// true: ping bursts are timed by a pin-change ISR and collected without
+// blocking loop(). false: legacy pulseIn() reads (~300 ms blocking).
+#define SENSOR_ASYNC_CAPTURE  true
+
+// true: one ping per reading through a Hampel outlier test and an alpha-beta
+// tracker (level + rate). false: median of a 5-ping burst per reading.
+#define SENSOR_STREAM_FILTER  true
+#define SENSOR_HAMPEL_WINDOW  7      // innovations in the outlier test (3..16)
+#define SENSOR_HAMPEL_K       3.0f   // outlier beyond K scaled MADs
+#define SENSOR_HAMPEL_MIN_CM  1.0f   // spread floor (sensor resolution)
+#define SENSOR_TRACK_ALPHA    0.5f   // level gain
+#define SENSOR_TRACK_BETA     0.1f   // rate gain
+#define SENSOR_MAX_RATE_CM_S  0.5f   // rate clamp: 30 cm/min, beyond any real river
+#define SENSOR_CONFIRM_PINGS  4      // extra pings to confirm a rejected/missed one
+
 // ─── Timing (milliseconds) ─────────────────────────────────────────────────
 #define SENSOR_READ_INTERVAL_MS    2000UL       // Read sensor every 2 s
 #define LOG_INTERVAL_MS            60000UL      // Log to CSV every 1 min
 #define WEATHER_POLL_INTERVAL_MS   1800000UL    // Poll weather every 30 min
-#define WS_BROADCAST_INTERVAL_MS   2000UL       // WebSocket push every 2 s
+#define WS_BROADCAST_INTERVAL_MS   2000UL       // WebSocket change check every 2 s
+#define WS_KEYFRAME_INTERVAL_MS    30000UL      // Full WebSocket frame at least every 30 s
+#define LIVE_JSON_MAX              384          // /api/status and WebSocket frame buffer (bytes)
 #define CLOUD_PUSH_INTERVAL_MS     15000UL      // Push to Netlify every 15 s
+#define SETTINGS_FLUSH_DELAY_MS    5000UL       // Write settings to flash 5 s after the last change
+
+// ─── Adaptive Sampling ─────────────────────────────────────────────────────
+// Sample slowly while the level is calm and far from the thresholds, and
+// speed up as it rises, nears the warning level or rain is forecast.
+// false: fixed SENSOR_READ_INTERVAL_MS (or the cloud's nextInterval).
+#define SAMPLE_ADAPTIVE            true
+#define SAMPLE_MIN_INTERVAL_MS     SENSOR_READ_INTERVAL_MS  // flood rate
+#define SAMPLE_MAX_INTERVAL_MS     300000UL     // calm rate: every 5 min
+#define SAMPLE_RAIN_INTERVAL_MS    30000UL      // at most 30 s while rain is expected
+#define SAMPLE_NEAR_MARGIN_CM      50.0f        // speed up within 50 cm of the warning level
+#define SAMPLE_STEPS_TO_WARNING    10           // readings left before a projected warning
+#define SAMPLE_TREND_WINDOW        8            // readings in the rise-rate fit
 
 // ─── OpenWeatherMap ─────────────────────────────────────────────────────────
 #define OWM_API_KEY   "7e4bc4f56020ed1937bfaada3797e964"
@@ -41,12 +72,93 @@
 #define NOTIFICATIONS_ENABLED  true
 #define TELEGRAM_BOT_TOKEN    "8378172918:AAEIjWzWkwUKgtTyIGav4QNJD-XDgDugNXY"
 #define TELEGRAM_CHAT_ID      "8336474821"
-#define TELEGRAM_COOLDOWN_MIN  1  // Wait 30 min before sending another alert
+#define TELEGRAM_COOLDOWN_MIN  1  // Alarms within this window go out as one summary
+#define NOTIFY_QUEUE_SIZE           6        // messages waiting to be sent
+#define NOTIFY_MAX_ATTEMPTS         5        // then the message is dropped
+#define NOTIFY_RETRY_BASE_MS        5000UL   // first retry delay, doubled per failure
+#define NOTIFY_RETRY_MAX_MS         300000UL // backoff cap (5 min)
+#define NOTIFY_RESPONSE_TIMEOUT_MS  8000UL   // wait for the Bot API to answer
+#define NOTIFY_TEXT_MAX             200      // bytes per queued message, incl. NUL
+
+// ─── History / LittleFS ────────────────────────────────────────────────────
+#define HISTORY_PATH          "/history.csv"  // legacy CSV, imported once at boot
+#define HISTORY_RING_PATH     "/history.bin"  // fixed-record ring buffer
+#define HISTORY_RING_CAPACITY 144   // 24 hours at 10-min intervals
+#define HISTORY_MIN_EPOCH     1000000000UL  // 2001: earlier means NTP hasn't synced yet
+#define RING_SEGMENT_BYTES    2048  // RingFile segment file size (LittleFS copies
+                                    // up to one segment per append)
+
+// Compressed long-term archive of every logged reading (~2 bytes each)
+#define ARCHIVE_PATH          "/archive.bin"
+#define ARCHIVE_BLOCK_SIZE    256   // bytes per block, one flash page
+#define ARCHIVE_BLOCKS        1024  // 256 KB: ~120k readings, ~80 days at 1 min
+#define ARCHIVE_SEGMENT_BYTES 8192  // 31 blocks per segment file, one LittleFS block
+
+// Dashboard, as written by scripts/compress_fs.py
+#define WEB_SHELL_GZ_PATH     "/index.html.gz"  // HTML shell, revalidated by ETag
+#define WEB_SHELL_PATH        "/index.html"     // uncompressed fallback
+#define WEB_ASSET_DIR         "/a/"             // content-hashed, cached for a year
 
-// ─── CSV / LittleFS ────────────────────────────────────────────────────────
-#define HISTORY_PATH     "/history.csv"
-#define MAX_CSV_ENTRIES  144   // 24 hours at 10-min intervals
+// Rollup tiers (min/max/mean/last per bucket, 24 bytes each)
+#define ROLLUP_MINUTE_PATH     "/rollup_m.bin"
+#define ROLLUP_MINUTE_CAPACITY 1440  // 24 hours
+#define ROLLUP_HOUR_PATH       "/rollup_h.bin"
+#define ROLLUP_HOUR_CAPACITY   744   // 31 days
+#define ROLLUP_DAY_PATH        "/rollup_d.bin"
+#define ROLLUP_DAY_CAPACITY    366   // 1 year
 
 // ─── Netlify Cloud Push ────────────────────────────────────────────────────
 #define CLOUD_NETLIFY_URL "https://floodalarm.netlify.app/.netlify/functions/push-status"
 #define CLOUD_API_KEY     "nfp_hHjozGS5UyWGkNTjkyoQVNThqVoudhjRac1d"
+#define CLOUD_RESPONSE_TIMEOUT_MS  8000UL  // wait for the function to answer
+#define CLOUD_BATCH_SIZE           10       // readings per upload (1 = one POST per reading)
+#define CLOUD_BATCH_MAX_AGE_MS     300000UL // flush a partial batch after 5 min
+#define CLOUD_PAYLOAD_MAX          1024     // request body buffer (bytes)
+
+// Store-and-forward queue for readings the cloud hasn't acknowledged
+#define OUTBOX_PATH                "/outbox.bin"
+#define OUTBOX_CAPACITY            4320     // 3 days of 1-min readings (8 B each)
+#define OUTBOX_DROP_OLDEST         true     // when full: drop oldest (true) or newest (false)
+#define OUTBOX_REPLAY_BATCH        30       // readings per replay request
+#define OUTBOX_REPLAY_INTERVAL_MS  10000UL  // at most one replay-only request per 10 s
+#define OUTBOX_CHECKPOINT_ACKS     10       // persist the queue tail every 10 acked batches
+
+// ─── Low-Power Mode ────────────────────────────────────────────────────────
+// For battery/solar stations. In both low-power modes the web UI is only
+// reachable while the radio is up, and a reading past the warning level
+// brings WiFi up at once and keeps it up until the level is NORMAL again.
+#define LOW_POWER_OFF             0   // always on: web UI, live WebSocket
+#define LOW_POWER_MODEM_SLEEP     1   // CPU samples, radio off between uploads
+#define LOW_POWER_DEEP_SLEEP      2   // sleep between samples (GPIO16 → RST)
+#define LOW_POWER_MODE            LOW_POWER_OFF
+#define LOW_POWER_FLUSH_READINGS  30        // upload once this many are buffered
+#define LOW_POWER_FLUSH_MAX_AGE_S 3600UL    // ...or the oldest is 1 h old
+#define LOW_POWER_WIFI_TIMEOUT_MS 30000UL   // longest upload window
+#define LOW_POWER_SETUP_WINDOW_MS 300000UL  // stay awake 5 min after power-on
+
+// Supply currents for the energy estimate (D1 mini + JSN-SR04T at 3.3 V)
+#define POWER_SUPPLY_V            3.3f
+#define POWER_RADIO_ON_MA         75.0f     // CPU + WiFi associated
+#define POWER_RADIO_OFF_MA        18.0f     // CPU + sensor, modem asleep
+#define POWER_DEEP_SLEEP_MA       0.2f      // incl. regulator and USB bridge
+
+// ─── Task Scheduler ────────────────────────────────────────────────────────
+#define SCHED_MAX_TASKS          24       // 16 registered, room to grow
+#define SCHED_MAX_IDLE_MS        50UL     // longest sleep between scheduler passes
+#define SCHED_SENSOR_POLL_MS     5UL      // echo burst service rate while one runs
+#define SCHED_CLOUD_STEP_MS      10UL     // cloud/Telegram step rate mid-request
+#define SCHED_LINK_CHECK_MS      1000UL   // queued uploads re-check WiFi this often
+
+// ─── Diagnostics ───────────────────────────────────────────────────────────
+#define METRICS_HEAP_SAMPLE_MS   1000UL   // free heap / max block sample rate
+#define METRICS_HEAP_DAYS        30       // daily heap minima kept for /metrics
+#define SCRATCH_ARENA_SIZE       2048     // shared per-request JSON scratch (bytes)
+
+// ─── Outbound Connection Pool ──────────────────────────────────────────────
+#define POOL_MAX_HOSTS           3        // Netlify, Telegram, OpenWeatherMap
+#define POOL_MAX_TLS_CONTEXTS    1        // ~20 KB heap with full-size buffers
+#define POOL_TLS_BUFFER_BYTES    512      // TLS record buffers when the server
+                                          // accepts max fragment length (MFLN)
+#define POOL_LOW_HEAP_BYTES      12000UL  // below this, idle sockets are closed
+#define POOL_CONNECT_TIMEOUT_MS  5000UL   // TCP + TLS handshake
+#define POOL_IDLE_TIMEOUT_MS     60000UL  // close keep-alive sockets after 1 min
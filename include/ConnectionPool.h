@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+/// Shared keep-alive connections for all outbound HTTP(S) traffic.
+///
+/// One slot per host keeps the socket open between requests and caches the
+/// TLS session, so a reconnect resumes instead of doing a full handshake.
+/// At most POOL_MAX_TLS_CONTEXTS TLS connections are live at once; idle ones
+/// are closed least-recently-used first to make room, and all idle sockets
+/// are closed while free heap is below POOL_LOW_HEAP_BYTES. Hosts that
+/// accept the max fragment length extension get POOL_TLS_BUFFER_BYTES TLS
+/// buffers.
+namespace ConnPool {
+    struct Stats {
+        uint32_t connects;        // new TCP connections opened
+        uint32_t handshakes;      // TLS handshakes performed
+        uint32_t resumeAttempts;  // handshakes offered a cached session
+        uint32_t reuses;          // requests served on an already-open socket
+        uint32_t evictions;       // idle connections closed for the caps or low heap
+        uint32_t smallBuffers;    // TLS connects with MFLN-sized buffers
+        uint32_t failures;        // connect/handshake failures
+    };
+
+    /// Borrow a connected client for host:port, reusing an open socket when
+    /// possible. Returns nullptr if the connection failed or every TLS
+    /// context is in use. Must be handed back with release().
+    WiFiClient* acquire(const char* host, uint16_t port, bool secure);
+
+    /// Return a borrowed client. Pass keepAlive=false if the server asked to
+    /// close or the exchange failed midway; the socket is then shut down
+    /// (the TLS session stays cached for resumption).
+    void release(WiFiClient* client, bool keepAlive = true);
+
+    /// Close idle sockets that exceeded POOL_IDLE_TIMEOUT_MS. Call from loop().
+    void loop();
+
+    const Stats& getStats();
+}
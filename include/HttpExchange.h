@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+/// One outbound HTTP/1.1 request on a pooled keep-alive connection, advanced
+/// a step at a time so the caller never waits on the network.
+///
+///   IDLE → CONNECTING → SENDING → RECEIVING → DONE | FAILED
+///
+/// Each step() performs at most one transition, and RECEIVING only drains
+/// what the socket already buffered. CONNECTING is the one step that may
+/// block, for a (resumed when possible) TLS handshake in ConnPool.
+class HttpExchange {
+public:
+  enum class State : uint8_t { IDLE, CONNECTING, SENDING, RECEIVING, DONE, FAILED };
+
+  /// Start a request. `headers` holds extra header lines, each terminated
+  /// by "\r\n"; Host, Connection and Content-Length are added here.
+  /// `body` is not copied: it must stay unchanged until the exchange
+  /// finishes (or reset()).
+  void begin(const String &host, uint16_t port, bool secure, const char *method,
+             const String &path, const String &headers, const char *body,
+             size_t bodyLen, unsigned long timeoutMs);
+
+  /// Advance one step. Returns true on the step that finished the exchange.
+  bool step();
+
+  /// Drop buffers and return to IDLE. Call after reading the result.
+  void reset();
+
+  State state() const { return _state; }
+  bool busy() const {
+    return _state != State::IDLE && _state != State::DONE && _state != State::FAILED;
+  }
+
+  /// HTTP status code once DONE.
+  int status() const { return _status; }
+
+  /// Response body (dechunked) once DONE.
+  const String &body() const { return _body; }
+
+  /// Why the exchange FAILED ("connect", "write", "timeout", "response too
+  /// large", ...).
+  const char *error() const { return _error; }
+
+private:
+  void enter(State next);
+  void fail(const char *reason);
+  void releaseClient(bool keepAlive);
+  void sendRequest();
+  void receive();
+  void parseHeaders();
+  bool bodyComplete() const;
+  void finishResponse(bool keepAlive);
+
+  State _state = State::IDLE;
+  unsigned long _stateSince = 0;
+  unsigned long _timeoutMs = 0;
+  WiFiClient *_client = nullptr; // borrowed from ConnPool
+
+  String _host;
+  uint16_t _port = 443;
+  bool _secure = true;
+  String _head;    // request line and headers until written
+  const char *_payload = nullptr; // caller's request body until written
+  size_t _payloadLen = 0;
+  String _response;
+  String _body;
+  int _status = 0;
+  const char *_error = "";
+
+  // Response framing, filled in once the header block has arrived
+  int _headerEnd = -1;
+  long _contentLength = -1;
+  bool _chunked = false;
+  bool _serverCloses = false;
+};
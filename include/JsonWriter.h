@@ -0,0 +1,109 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+/// Streaming JSON serializer for payloads whose schema is fixed in code.
+///
+/// A schema is plain code: a sequence of key()/value() calls. Keys are
+/// string literals, so their length is part of the type and they are copied
+/// without strlen() or escaping; the value overload (and the integer width)
+/// is picked at compile time. Nothing is built in memory: each call appends
+/// straight into the caller's buffer.
+///
+/// Output past the buffer is dropped, but length() keeps counting, so a
+/// writer over (nullptr, 0) measures a document and overflowed() tells the
+/// caller to retry with length() + 1 bytes. The text is NUL-terminated
+/// whenever the buffer has room for it.
+///
+///   char buf[64];
+///   JsonWriter w(buf, sizeof(buf));
+///   w.beginObject().key("type").value("history").key("val").fixed(1234, 1);
+///   w.endObject(); // {"type":"history","val":123.4}
+class JsonWriter {
+public:
+  JsonWriter(char *buf, size_t size) : _buf(buf), _size(size) {
+    if (_size > 0)
+      _buf[0] = '\0';
+  }
+
+  JsonWriter &beginObject() { return open('{'); }
+  JsonWriter &endObject() { return close('}'); }
+  JsonWriter &beginArray() { return open('['); }
+  JsonWriter &endArray() { return close(']'); }
+
+  /// Object key. Must be a literal that needs no escaping.
+  template <size_t N> JsonWriter &key(const char (&name)[N]) {
+    separator();
+    put('"');
+    put(name, N - 1);
+    put("\":", 2);
+    _afterKey = true;
+    return *this;
+  }
+
+  /// Escaped string; nullptr is written as null.
+  JsonWriter &value(const char *s);
+  JsonWriter &value(bool b);
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                              !std::is_same<T, bool>::value,
+                          JsonWriter &>::type
+  value(T v) {
+    separator();
+    if (std::is_signed<T>::value)
+      putSigned((long long)v);
+    else
+      putUnsigned((unsigned long long)v);
+    return *this;
+  }
+
+  /// `scaled` / 10^decimals, without trailing zeros (1230, 1 → 123).
+  JsonWriter &fixed(long scaled, uint8_t decimals);
+
+  /// `v` rounded to `decimals` places; NaN and infinity become null.
+  JsonWriter &value(float v, uint8_t decimals);
+
+  /// Bytes the document needs, excluding the NUL, even if they didn't fit.
+  size_t length() const { return _len; }
+  bool overflowed() const { return _len >= _size; }
+  const char *c_str() const { return _buf; }
+
+private:
+  JsonWriter &open(char c) {
+    separator();
+    put(c);
+    _depth++;
+    _comma &= ~(1UL << _depth);
+    return *this;
+  }
+
+  JsonWriter &close(char c) {
+    _depth--;
+    put(c);
+    return *this;
+  }
+
+  /// Comma before every member or element but the first one.
+  void separator() {
+    if (_afterKey) {
+      _afterKey = false;
+      return;
+    }
+    if (_comma & (1UL << _depth))
+      put(',');
+    _comma |= 1UL << _depth;
+  }
+
+  void put(char c) { put(&c, 1); }
+  void put(const char *s, size_t n);
+  void putUnsigned(unsigned long long v);
+  void putSigned(long long v);
+
+  char *_buf;
+  size_t _size;
+  size_t _len = 0;
+  uint32_t _comma = 0; // bit d: depth d already has a member
+  uint8_t _depth = 0;
+  bool _afterKey = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include "StorageManager.h"
+
+/// The fixed-schema JSON the dashboard consumes: `/api/status`, the live
+/// WebSocket frame and the history-append event. Each writer fills a
+/// caller-supplied buffer through JsonWriter and returns the JSON length,
+/// or the length it would need (> size - 1) if the buffer is too small.
+namespace LivePayload {
+    /// What the dashboard displays, in the units it displays.
+    ///
+    /// Text fields are compared by hash, so taking a snapshot every tick
+    /// copies no strings. The text pointers are only valid while the
+    /// snapshot is being written out.
+    struct Snapshot {
+        long distance10; // tenths of cm, the resolution clients display
+        long warning10;
+        long alarm10;
+        bool rainExpected;
+        uint32_t forecastHash;
+        uint32_t stationHash;
+        uint32_t riverHash;
+        uint32_t interval; // seconds
+        const char* status;
+        const char* forecast;
+        const char* station;
+        const char* river;
+
+        bool operator==(const Snapshot& o) const {
+            return distance10 == o.distance10 && warning10 == o.warning10 &&
+                   alarm10 == o.alarm10 && rainExpected == o.rainExpected &&
+                   interval == o.interval && strcmp(status, o.status) == 0 &&
+                   forecastHash == o.forecastHash && stationHash == o.stationHash &&
+                   riverHash == o.riverHash;
+        }
+    };
+
+    /// FNV-1a over `len` bytes. Pass the previous result as `hash` to
+    /// continue over the next chunk.
+    uint32_t fnv1a(const char* s, size_t len, uint32_t hash = 2166136261UL);
+
+    /// Point the snapshot's text fields at `forecast` and the current
+    /// station/river settings, and hash them.
+    void setText(Snapshot& snap, const char* forecast);
+
+    /// `/api/status` body.
+    size_t writeStatus(char* buf, size_t size, const Snapshot& s, int entries,
+                       int confidence);
+
+    /// Live frame: every field ("type":"full") when `prev` is null, else
+    /// only the fields that differ from `prev` ("type":"delta").
+    size_t writeFrame(char* buf, size_t size, const Snapshot& cur,
+                      const Snapshot* prev);
+
+    /// `{"type":"history","seq":N,"ts":epoch,"val":cm}`
+    size_t writeHistoryAppend(char* buf, size_t size, const StorageMgr::Reading& r,
+                              uint32_t seq);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+
+/// Lightweight per-stage timing of loop() plus heap telemetry.
+///
+/// Every stage keeps count, last, max, total and a log-bucketed latency
+/// histogram (bucket bounds grow 4x from 64 µs to ~1 s). Recording is a
+/// handful of integer ops, so it can stay enabled in production.
+namespace Metrics {
+    enum Stage : uint8_t {
+        SENSOR = 0,   // trigger a burst / blocking read
+        SENSOR_POLL,  // advance the async burst
+        READING,      // thresholds, buzzer, Telegram/cloud enqueue
+        WEBSOCKET,    // live frame + client cleanup
+        LOG,          // history ring + rollups
+        WEATHER,      // OpenWeatherMap poll
+        MANUAL_SYNC,
+        MIGRATION,
+        CLOUD,        // CloudSync state machine step
+        NOTIFY,       // Telegram send queue step
+        POOL,         // idle socket reaping
+        SETTINGS,     // debounced Preferences write-back
+        LOOP,         // one scheduler dispatch (task + overhead)
+        STAGE_COUNT
+    };
+
+    static const uint8_t BUCKET_COUNT = 9; // 8 bounded buckets + overflow
+
+    struct StageStats {
+        uint32_t count;
+        uint32_t lastUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t buckets[BUCKET_COUNT]; // non-cumulative
+    };
+
+    /// End-to-end latencies of the alarm pipeline, measured from the moment
+    /// the sensor sample completed.
+    enum Latency : uint8_t {
+        SAMPLE_TO_BUZZER = 0, // buzzer pin driven for the new status
+        SAMPLE_TO_WS,         // status-change frame queued to WebSocket clients
+        LATENCY_COUNT
+    };
+
+    /// Add one duration sample to `stage`.
+    void record(Stage stage, uint32_t durationUs);
+
+    /// Add one end-to-end latency sample.
+    void recordLatency(Latency which, uint32_t latencyUs);
+
+    /// Times the enclosing block into `stage`.
+    class Scope {
+    public:
+        explicit Scope(Stage stage) : _stage(stage), _start(micros()) {}
+        ~Scope() { record(_stage, micros() - _start); }
+
+    private:
+        Stage _stage;
+        uint32_t _start;
+    };
+
+    /// Sample free heap and largest free block (rate-limited to
+    /// METRICS_HEAP_SAMPLE_MS) and fold them into the minima of the current
+    /// uptime day; the last METRICS_HEAP_DAYS days are kept. Call once per
+    /// loop.
+    void sampleHeap();
+
+    const StageStats& getStage(Stage stage);
+    const StageStats& getLatency(Latency which);
+    const char* stageName(Stage stage);
+
+    /// Upper bound of histogram bucket `i` in µs (0 for the overflow bucket).
+    uint32_t bucketBoundUs(uint8_t i);
+
+    /// Write everything in the Prometheus text exposition format (0.0.4).
+    void writePrometheus(Print& out);
+}
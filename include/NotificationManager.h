@@ -1,9 +1,50 @@
 #pragma once
 #include <Arduino.h>
 
+/// Outbound Telegram messages, queued and sent in the background.
+///
+/// Messages wait in a small FIFO and are delivered one at a time by loop()
+/// as JSON POSTs over the shared connection pool. A failed send is retried
+/// with exponential backoff; a message the API rejects outright is dropped.
 namespace NotificationMgr {
-    /// Send a message to Telegram.
-    /// @param message The text to send.
-    /// @return true if successfully sent.
-    bool sendTelegram(const String& message);
+    struct Stats {
+        uint32_t sent;       // messages Telegram accepted
+        uint32_t retries;    // attempts that failed and were rescheduled
+        uint32_t dropped;    // given up after NOTIFY_MAX_ATTEMPTS or rejected
+        uint32_t overflow;   // refused because the queue was full
+        uint32_t coalesced;  // alarm readings folded into a summary
+    };
+
+    /// Queue a message (copied; cut at NOTIFY_TEXT_MAX - 1 bytes). Returns
+    /// false if notifications are disabled, the credentials are unset or the
+    /// queue is full.
+    bool queueTelegram(const char* message);
+
+    /// Called when a message is queued, so the caller can schedule loop()
+    /// again.
+    typedef void (*WakeCallback)();
+    void onWake(WakeCallback callback);
+
+    /// Report an ALARM reading. The first one is sent right away; further
+    /// alarms within TELEGRAM_COOLDOWN_MIN are counted and go out as a single
+    /// summary when the cooldown ends.
+    /// @param distanceCm Measured distance to the water (cm)
+    void reportAlarm(float distanceCm);
+
+    /// Advance the sender by one step and emit due alarm summaries.
+    /// Never waits on the network, except for a TLS handshake in ConnPool.
+    void loop();
+
+    /// True while messages are queued or one is in flight.
+    bool hasPending();
+
+    /// Milliseconds until loop() has something to do: 0 while a send is in
+    /// flight or due, the retry backoff, the link or the end of an alarm
+    /// cooldown otherwise, -1 when nothing is pending.
+    int32_t nextStepMs();
+
+    /// Messages waiting, including the one in flight.
+    uint8_t depth();
+
+    const Stats& getStats();
 }
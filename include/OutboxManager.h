@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+/// Persistent store-and-forward queue for readings the cloud hasn't
+/// acknowledged yet. Backed by a RingFile on LittleFS, so the backlog
+/// survives reboots and is replayed oldest-first once the link is back.
+namespace OutboxMgr {
+    /// One queued reading (distance in 1/10 cm, as sent in a cloud batch).
+    struct Entry {
+        uint32_t epoch;
+        int32_t tenths;
+    };
+
+    /// Open the queue. Call after LittleFS is mounted.
+    void begin();
+
+    /// Append readings. When full, OUTBOX_DROP_OLDEST decides whether the
+    /// oldest queued reading or the incoming one is discarded.
+    void push(const Entry* entries, uint16_t count);
+
+    /// Copy up to `max` of the oldest readings without removing them.
+    uint16_t peek(Entry* out, uint16_t max);
+
+    /// Remove the `count` oldest readings (after the cloud acknowledged them).
+    /// The new tail reaches flash every OUTBOX_CHECKPOINT_ACKS acks or when
+    /// the queue drains, so a reset may resend a few acknowledged batches.
+    void pop(uint16_t count);
+
+    /// Remove the `count` oldest readings undelivered, e.g. one too large
+    /// to send. Counted in dropped().
+    void discard(uint16_t count);
+
+    /// Persist the tail now. Call before a restart or deep sleep.
+    void checkpoint();
+
+    /// Readings currently queued.
+    int depth();
+
+    /// Age in seconds of the oldest queued reading (0 when empty).
+    uint32_t lagSeconds();
+
+    /// Readings discarded because the queue was full or they couldn't be sent.
+    uint32_t dropped();
+
+    /// Readings delivered from the queue since boot.
+    uint32_t replayed();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+
+/// Opt-in low-power operation for battery and solar stations (LOW_POWER_MODE).
+///
+/// LOW_POWER_MODEM_SLEEP: the CPU keeps sampling, the radio is switched off
+/// between uploads and woken when LOW_POWER_FLUSH_READINGS have accumulated,
+/// the oldest is LOW_POWER_FLUSH_MAX_AGE_S old or a reading leaves NORMAL.
+///
+/// LOW_POWER_DEEP_SLEEP: the chip sleeps between samples (GPIO16 wired to
+/// RST). A timer wake boots with the radio off, takes one reading, stores
+/// it in RTC memory and sleeps again; only the same upload triggers boot
+/// the full firmware with WiFi. While the level is not NORMAL the station
+/// stays fully awake.
+///
+/// Energy per sample is estimated from the measured time spent with the
+/// radio on, radio off and asleep, times the POWER_*_MA supply currents.
+namespace PowerMgr {
+    struct Stats {
+        uint32_t wakes;             // deep-sleep timer wakes
+        uint32_t samples;           // readings taken in total
+        uint32_t radioOnMs;         // awake with WiFi up
+        uint32_t radioOffMs;        // awake with the radio off
+        uint32_t sleepS;            // in deep sleep
+        uint32_t radioWakes;        // times WiFi came up to upload or alert
+        uint32_t lastWakeToSampleUs; // timer wake (boot) to reading done
+        uint32_t maxWakeToSampleUs;
+    };
+
+    /// Call at the top of setup(), after Serial.begin(). On a deep-sleep
+    /// timer wake this takes the reading and goes back to sleep without
+    /// returning, unless the reading needs WiFi.
+    void begin();
+
+    /// True when this boot is a deep-sleep wake (skip boot delays).
+    bool wokeFromSleep();
+
+    /// True when this boot was caused by an ALARM reading, so the buzzer can
+    /// sound before WiFi is up. Cleared by the first NORMAL reading.
+    bool alarmWake();
+
+    /// Move readings buffered in RTC memory to the outbox. Call once
+    /// OutboxMgr is up.
+    void flushRtcBuffer();
+
+    /// WiFi failed on a radio wake: sleep and try again at the next upload
+    /// trigger rather than blocking on the battery. On a wake for a reading
+    /// past a threshold it returns true instead: carry on without WiFi, the
+    /// station must not sleep while the level is high. False (and no-op) on
+    /// other boots.
+    bool retryLater();
+
+    /// Called when WiFi comes back for an upload window; typically forces a
+    /// cloud push of the latest reading.
+    void onRadioUp(void (*callback)());
+
+    /// Count a reading. `urgent` (status not NORMAL) keeps the radio on and
+    /// blocks deep sleep; a NORMAL reading ends an alarm wake.
+    void noteSample(bool urgent);
+
+    /// Switch the radio or enter deep sleep when nothing is left to send.
+    void loop();
+
+    const Stats& getStats();
+
+    /// Estimated energy per reading (mJ) and average supply current (mA).
+    float energyPerSampleMJ();
+    float averageCurrentMA();
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "Config.h"
+
+/// Circular log of fixed-size binary records on LittleFS.
+///
+/// Records are only ever appended. The ring is split into segment files
+/// `<path>.0`, `<path>.1`, ... of at most `segmentBytes`; each starts with
+/// the sequence number of its first record, so head and tail are found at
+/// boot from those headers alone. LittleFS commits a write by copying the
+/// file from the written block to its end, so appending to a small segment
+/// costs at most one segment, where rewriting a header at offset 0 would
+/// cost the whole file. The oldest segment is recycled once the ring is
+/// full. Only dropOldest()/clear() write anything else: the tail sequence
+/// number in `<path>.t`.
+class RingFile {
+public:
+  RingFile(const char *path, uint16_t recordSize, uint32_t capacity,
+           uint16_t segmentBytes = RING_SEGMENT_BYTES);
+
+  /// Find head and tail from the segment headers, importing a ring in the
+  /// old single-file layout if present. Returns false if LittleFS failed.
+  bool begin();
+
+  /// Append one record, dropping the oldest when full.
+  bool append(const void *record);
+
+  /// Append `n` consecutive records with a single sync.
+  bool appendMany(const void *records, uint32_t n);
+
+  /// Overwrite the newest record in place (no-op on an empty ring).
+  bool updateLast(const void *record);
+
+  /// Read the i-th record counting from the oldest (0 = oldest).
+  bool read(uint32_t index, void *record);
+
+  /// Read `len` bytes at `offset` within the i-th record (0 = oldest).
+  bool read(uint32_t index, void *buf, uint16_t offset, uint16_t len);
+
+  /// Discard the `n` oldest records (clamped to count()). With `persist`
+  /// false the new tail is only kept in RAM until the next syncTail(); a
+  /// reset before that brings the dropped records back.
+  void dropOldest(uint32_t n, bool persist = true);
+
+  /// Write the tail if dropOldest() left it unsaved.
+  bool syncTail();
+
+  /// Drop all records.
+  void clear();
+
+  uint32_t count() const { return _total - _oldest; }
+  uint32_t capacity() const { return _capacity; }
+  bool isFull() const { return count() == _capacity; }
+
+  /// Number of records ever appended; survives wrap-around and reboots.
+  uint32_t total() const { return _total; }
+
+private:
+  struct SegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t firstSeq; // sequence number of the segment's first record
+  };
+
+  struct TailFile {
+    uint32_t magic;
+    uint32_t seq; // records before this one were dropped
+  };
+
+  void segmentPath(uint16_t seg, char *out) const;
+  uint16_t segmentOf(uint32_t seq) const {
+    return (seq / _perSegment) % _segments;
+  }
+  uint32_t offsetOf(uint32_t seq) const {
+    return sizeof(SegmentHeader) + (seq % _perSegment) * (uint32_t)_recordSize;
+  }
+
+  bool readSegment(uint16_t seg, uint32_t &firstSeq, uint32_t &stored);
+  bool scan();
+  void importLegacy();
+  bool writeTail();
+  bool openHead(uint32_t seq);
+  bool writeRecords(const uint8_t *records, uint32_t n);
+  File *fileFor(uint32_t seq);
+
+  const char *_path;
+  uint16_t _recordSize;
+  uint32_t _capacity;
+  uint32_t _perSegment; // records per segment
+  uint16_t _segments;   // segment files, one more than the capacity needs
+
+  uint32_t _oldest = 0; // sequence number of the oldest live record
+  uint32_t _total = 0;  // sequence number of the next record
+
+  File _head;           // segment being appended to
+  uint32_t _headFirst = 0;
+  bool _headOpen = false;
+  File _reader;         // cached handle on an older segment
+  uint32_t _readerFirst = 0;
+  bool _readerOpen = false;
+  bool _tailDirty = false;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+
+/// Multi-resolution history: min/max/mean/last per minute, hour and day,
+/// each tier kept in its own bounded ring on LittleFS.
+///
+/// The bucket being filled lives in RAM and is appended once, when a
+/// reading crosses into the next bucket. After a reboot the open buckets
+/// are replayed from the archive (levels rounded to 0.1 cm).
+namespace RollupMgr {
+    enum Resolution : uint8_t { MINUTE = 0, HOUR, DAY, RESOLUTION_COUNT };
+
+    /// One aggregated bucket as stored on flash (24 bytes).
+    struct Bucket {
+        uint32_t start;   // epoch of the bucket start (aligned to its width)
+        float min;
+        float max;
+        float mean;
+        float last;
+        uint32_t count;
+    };
+
+    /// Open the rollup rings and rebuild the open buckets. Call once the
+    /// history ring and the archive are open.
+    void begin();
+
+    /// Fold one reading into every tier. A bucket is written to flash only
+    /// when the reading crosses its boundary.
+    void addReading(unsigned long epochSeconds, float distanceCm);
+
+    /// Number of buckets stored for a tier (including the open one).
+    int getBucketCount(Resolution res);
+
+    /// Read the i-th bucket of a tier (0 = oldest).
+    bool getBucket(Resolution res, int index, Bucket& out);
+
+    /// Parse "minute" / "hour" / "day". Returns false for anything else.
+    bool parseResolution(const String& name, Resolution& out);
+
+    const char* resolutionName(Resolution res);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+
+/// Adaptive sensor sample rate.
+///
+/// The interval for the next reading is the shortest of:
+///  - the ceiling (SAMPLE_MAX_INTERVAL_MS, or the cloud's nextInterval),
+///  - SAMPLE_RAIN_INTERVAL_MS while rain is forecast,
+///  - a proximity term that shrinks linearly inside SAMPLE_NEAR_MARGIN_CM
+///    of the warning level,
+///  - a rise-rate term that leaves SAMPLE_STEPS_TO_WARNING samples before
+///    the projected warning crossing,
+/// clamped to SAMPLE_MIN_INTERVAL_MS. Speeding up takes effect at once,
+/// slowing down at most doubles the interval per sample.
+namespace SamplingMgr {
+    /// What set the current interval.
+    enum Reason : uint8_t {
+        BY_CEILING, BY_RAIN, BY_NEAR, BY_RISE, BY_THRESHOLD, BY_FIXED
+    };
+
+    /**
+     * @brief Feed a valid reading and compute the next sample interval.
+     * @param nowMs millis() of the reading
+     * @param distanceCm Measured distance to the water (cm)
+     * @param warnCm Active warning threshold (rain-adjusted)
+     * @param alarmCm Active alarm threshold (rain-adjusted)
+     * @param rainExpected WeatherSvc::isRainExpected()
+     * @return Interval until the next reading (ms)
+     */
+    uint32_t update(unsigned long nowMs, float distanceCm, float warnCm, float alarmCm,
+                    bool rainExpected);
+
+    /// Continue from a known interval, e.g. the length of the last deep sleep,
+    /// so the gradual back-off doesn't restart from the fastest rate.
+    void resume(uint32_t intervalMs);
+
+    /// Slowest allowed interval, e.g. from the cloud's nextInterval.
+    void setCeilingMs(uint32_t ms);
+
+    /// Interval returned by the last update().
+    uint32_t intervalMs();
+
+    /// Fitted rise rate in cm/h over the last SAMPLE_TREND_WINDOW readings.
+    /// Positive while the water is rising (distance shrinking).
+    float riseRateCmPerHour();
+
+    Reason reason();
+    const char* reasonName(Reason r);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+
+/// Cooperative, deadline-aware task scheduler driving loop().
+///
+/// Each runNext() call runs exactly one due task: the one with the highest
+/// priority, then the earliest due time. A newly due alarm task therefore
+/// never waits behind more than one lower-priority task. When nothing is
+/// due, idle() sleeps until the next task is (at most SCHED_MAX_IDLE_MS).
+namespace Scheduler {
+    typedef void (*TaskFn)(unsigned long now);
+    typedef int8_t TaskId;
+
+    static const TaskId INVALID_TASK = -1;
+
+    /// Lower value runs first.
+    enum Priority : uint8_t { PRIO_ALARM = 0, PRIO_HIGH, PRIO_NORMAL, PRIO_LOW };
+
+    struct TaskInfo {
+        const char* name;
+        uint32_t periodMs;     // 0 = event task, runs only when triggered
+        uint32_t deadlineMs;   // allowed start lateness, 0 = no deadline
+        uint8_t priority;
+        uint32_t runs;
+        uint32_t missedDeadlines;
+        uint32_t maxLatenessMs;
+    };
+
+    /// Register a task. Periodic tasks first run `periodMs` from now; event
+    /// tasks (period 0) only after trigger(). Returns INVALID_TASK when all
+    /// SCHED_MAX_TASKS slots are used.
+    TaskId add(const char* name, TaskFn fn, uint32_t periodMs, Priority priority,
+               uint32_t deadlineMs = 0);
+
+    /// Make a task due now (event tasks run once, periodic ones early).
+    void trigger(TaskId id);
+
+    /// Make a task due in `delayMs`, or keep it sooner if it already is.
+    /// An event task re-arms itself this way while it has work left.
+    void triggerIn(TaskId id, uint32_t delayMs);
+
+    /// Change a periodic task's period; the next run is rescheduled from now.
+    void setPeriod(TaskId id, uint32_t periodMs);
+
+    /// Run the most urgent due task. Returns false if none was due.
+    bool runNext();
+
+    /// Sleep until the next task is due (bounded by SCHED_MAX_IDLE_MS).
+    void idle();
+
+    uint8_t taskCount();
+    const TaskInfo& getTask(uint8_t index);
+
+    /// Total time spent in idle() since boot, in ms.
+    uint32_t idleMs();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/// Bump allocator for short-lived JSON documents: `JsonDocument
+/// doc(&ScratchArena::shared())`.
+///
+/// Allocations are carved from one static buffer and the whole buffer is
+/// reused as soon as every allocation has been released, so documents built
+/// and thrown away per request or per tick never touch the heap. When the
+/// buffer is exhausted the allocation falls back to malloc() (counted in
+/// heapFallbacks()), so an oversized document still works.
+class ScratchArena : public ArduinoJson::Allocator {
+public:
+  ScratchArena(uint8_t *buf, size_t size) : _buf(buf), _size(size) {}
+
+  void *allocate(size_t size) override;
+  void deallocate(void *ptr) override;
+  void *reallocate(void *ptr, size_t newSize) override;
+
+  size_t used() const { return _top; }
+  size_t capacity() const { return _size; }
+  /// Most bytes in use at once since boot.
+  size_t highWater() const { return _highWater; }
+  /// Allocations that didn't fit and went to the heap.
+  uint32_t heapFallbacks() const { return _fallbacks; }
+
+  /// The SCRATCH_ARENA_SIZE arena shared by the firmware's JSON paths.
+  static ScratchArena &shared();
+
+private:
+  bool owns(const void *ptr) const {
+    return ptr >= _buf && ptr < _buf + _size;
+  }
+
+  uint8_t *_buf;
+  size_t _size;
+  size_t _top = 0;          // first free byte
+  size_t _last = SIZE_MAX;  // offset of the newest block, if still live
+  uint16_t _live = 0;       // allocations not yet released
+  size_t _highWater = 0;
+  uint32_t _fallbacks = 0;
+};
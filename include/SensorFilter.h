@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+/// Streaming filter for single-ping distance readings.
+///
+/// Each ping is first checked by a Hampel identifier on the tracker's
+/// innovations (measurement minus prediction): it is an outlier when it sits
+/// more than SENSOR_HAMPEL_K scaled MADs from the median of the last
+/// SENSOR_HAMPEL_WINDOW innovations. Accepted pings then correct an
+/// alpha-beta tracker that carries distance and rate of change between
+/// ticks. A genuine step is accepted once it holds for half the window.
+/// Confirmation pings (less than half a read interval after the previous
+/// ping) correct the level but not the rate, and the rate is clamped to
+/// ±SENSOR_MAX_RATE_CM_S.
+class SensorFilter {
+public:
+  enum Result : uint8_t { PING_ACCEPTED, PING_REJECTED, PING_MISSED };
+
+  struct Estimate {
+    float distanceCm;  // smoothed distance, -1 until the first echo
+    float rateCmPerS;  // d(distance)/dt; negative while the water rises
+    float confidence;  // 0..1: echo hit ratio scaled by measurement spread
+  };
+
+  /// Feed one ping taken at `nowMs`; `measuredCm` <= 0 means no echo.
+  Result update(unsigned long nowMs, float measuredCm);
+
+  const Estimate &estimate() const { return _est; }
+  bool ready() const { return _initialised; }
+  void reset();
+
+private:
+  static const uint8_t WINDOW = SENSOR_HAMPEL_WINDOW;
+
+  void predict(unsigned long nowMs, float &dtS);
+  void recordOutcome(bool hit);
+
+  Estimate _est = {-1.0f, 0.0f, 0.0f};
+  bool _initialised = false;
+  unsigned long _lastMs = 0;
+
+  float _innov[WINDOW]; // recent innovations, accepted or not
+  uint8_t _innovLen = 0;
+  uint8_t _innovHead = 0;
+  float _sigma = SENSOR_HAMPEL_MIN_CM; // scaled MAD of the innovations
+
+  uint16_t _outcomes = 0; // bit per recent ping, 1 = accepted echo
+  uint8_t _outcomeLen = 0;
+};
@@ -3,10 +3,53 @@
 
 /// Manages the JSN-SR04T ultrasonic sensor.
 namespace SensorMgr {
-    /// Configure Trig/Echo pins.
+    /// Configure Trig/Echo pins and attach the echo pin-change ISR.
     void begin();
 
-    /// Read distance in cm (median of 5 readings for stability).
+    /// Read distance in cm: the streaming filter's estimate after one ping
+    /// (SENSOR_STREAM_FILTER), otherwise the median of 5 pings.
+    /// Blocks for up to ~300 ms; kept as a fallback for the async mode.
     /// Returns -1.0 if no valid echo received.
     float readDistanceCm();
+
+    /// Median of `pings` raw pings (at most 5), bypassing the streaming
+    /// filter. Returns -1.0 unless a majority of them echoed. For a
+    /// one-off decision on a fresh boot, where the filter has no history.
+    float readMedianCm(int pings);
+
+    // ── Non-blocking acquisition ────────────────────────────────────────
+    // The echo edges are timestamped in an ISR; poll() only advances the
+    // burst state machine and never waits on the sensor.
+
+    /// Called when requestReading() starts a burst, so the caller can
+    /// schedule poll() only while one runs.
+    typedef void (*BurstCallback)();
+    void onBurstStart(BurstCallback callback);
+
+    /// Start a burst of pings (one, plus confirmations, with the streaming
+    /// filter). Ignored if a burst is already running.
+    void requestReading();
+
+    /// True while a burst is in progress.
+    bool isBusy();
+
+    /// Advance the burst; call while isBusy(). Returns true once when the burst
+    /// completes, with the filtered or median distance (or -1.0 if no valid
+    /// echo) in `outCm`.
+    bool poll(float& outCm);
+
+    /// micros() at which the most recent reading was captured (its last echo
+    /// edge or timeout). Start point for the alarm latency measurements.
+    uint32_t lastSampleUs();
+
+    /// Rate of change of the filtered distance (cm/s, negative while the
+    /// water rises). 0 without the streaming filter.
+    float rateCmPerS();
+
+    /// Filter confidence 0..1 (echo hit ratio scaled by measurement spread).
+    /// Always 1 without the streaming filter.
+    float confidence();
+
+    /// Median of the first `n` entries (sorts in place). Returns -1 if n == 0.
+    float median(float* values, int n);
 }
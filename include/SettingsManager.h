@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+
+/// RAM-resident copy of the persisted settings.
+///
+/// Everything is read from Preferences once in begin(); getters never touch
+/// flash. Setters update RAM immediately, mark the key dirty and notify
+/// listeners; dirty keys are written back together once no further change
+/// arrived for SETTINGS_FLUSH_DELAY_MS.
+namespace SettingsMgr {
+    enum Key : uint8_t { STATION = 0, RIVER, WARNING_CM, ALARM_CM, KEY_COUNT };
+
+    /// Called after a setting changed in RAM (before it reaches flash).
+    typedef void (*ChangeCallback)(Key key);
+
+    /// Load all settings from Preferences.
+    void begin();
+
+    const String& station();
+    const String& river();
+    float warningThreshold();
+    float alarmThreshold();
+
+    /// Setters return true if the value actually changed.
+    bool setStation(const String& value);
+    bool setRiver(const String& value);
+    bool setWarningThreshold(float cm);
+    bool setAlarmThreshold(float cm);
+
+    /// Register a change listener (up to 4).
+    void onChange(ChangeCallback callback);
+
+    /// Write dirty keys once the debounce delay has passed. Call from loop().
+    void loop();
+
+    /// Write dirty keys now. Anything that restarts or deep-sleeps the chip
+    /// calls this first.
+    void flush();
+}
@@ -1,17 +1,108 @@
 #pragma once
 #include <Arduino.h>
+#include "ArchiveManager.h"
 
-/// Manages LittleFS-based CSV history logging.
+/// Manages the LittleFS history store (fixed-record binary ring buffer).
 namespace StorageMgr {
-    /// Mount LittleFS and create history.csv if it doesn't exist.
+    /// One logged sample as stored on flash (8 bytes).
+    struct Reading {
+        uint32_t epoch;
+        float distanceCm;
+    };
+
+    /// Mount LittleFS, open the history ring and import a
+    /// legacy history.csv if one is still present.
     void begin();
 
-    /// Append a timestamped reading to history.csv.
+    /// Append a timestamped reading, dropping the oldest when full. Readings
+    /// stamped before HISTORY_MIN_EPOCH (NTP not synced) or older than the
+    /// last one logged are skipped, so the history stays sorted by time.
     void logReading(unsigned long epochSeconds, float distanceCm);
 
-    /// Return the full CSV content as a String (for serving via HTTP).
-    String getCSV();
+    /// Sequence number the next logged reading will get. Every reading is
+    /// numbered in append order; numbers are never reused, so a client that
+    /// remembers the cursor can ask for just the readings after it.
+    uint32_t cursor();
+
+    /// Called after each reading is logged, with its sequence number.
+    void onAppend(void (*callback)(const Reading& r, uint32_t seq));
+
+    /// Read the i-th stored reading (0 = oldest). Returns false if out of range.
+    bool getReading(int index, Reading& out);
+
+    /// Index of the first reading logged at or after `epoch` (getEntryCount()
+    /// if none). Binary search over the ring: O(log n) flash reads.
+    int findFirstAtOrAfter(uint32_t epoch);
+
+    /// Sequential reader over the readings with `from` <= epoch <= `to`,
+    /// oldest first. Both ends are found by binary search, so opening a
+    /// window costs O(log n) whatever the history size.
+    class RangeReader {
+    public:
+        /// `since` additionally skips readings numbered below it (see cursor()).
+        RangeReader(uint32_t from = 0, uint32_t to = UINT32_MAX, uint32_t since = 0);
+
+        /// Read the next reading in range; false once past the end.
+        /// Readings overwritten since the reader was opened are skipped.
+        bool next(Reading& out);
+
+        /// Readings left before the end of the range.
+        uint32_t remaining() const { return _end > _next ? _end - _next : 0; }
+
+        /// Sequence number one past the range.
+        uint32_t end() const { return _end; }
+
+    private:
+        uint32_t _next; // sequence numbers, not ring indices, so appends
+        uint32_t _end;  // while reading don't shift the window
+    };
+
+    /// A slice of the history rendered as JSON or CSV a buffer at a time,
+    /// e.g. from a chunked HTTP response. Holds only the ring position and
+    /// one formatted record, so heap use doesn't grow with the range.
+    class HistoryStream {
+    public:
+        /// Readings with `from` <= epoch <= `to`. If more than `limit`
+        /// (0 = no limit) fall in the range, each output point stands for a
+        /// group of readings and is the one with the highest water in it,
+        /// so downsampling never hides a peak. `since` skips readings
+        /// numbered below it (see cursor()). A `from` older than the raw
+        /// ring (without `since`) is answered from the compressed archive.
+        HistoryStream(bool json, uint32_t from = 0, uint32_t to = UINT32_MAX,
+                      uint32_t limit = 0, uint32_t since = 0);
+
+        /// Copy up to `maxLen` bytes of output into `buf`; 0 once finished.
+        size_t read(uint8_t* buf, size_t maxLen);
+
+        /// Readings per output point (1 unless downsampled).
+        uint32_t stride() const { return _stride; }
+
+        /// Cursor to pass as `since` on the next request.
+        uint32_t next() const { return _range.end(); }
+
+    private:
+        enum Phase : uint8_t { HEADER, ROWS, FOOTER, DONE };
+        bool format();
+        bool nextReading(Reading& r);
+
+        bool _json;
+        Phase _phase = HEADER;
+        RangeReader _range;
+        bool _fromArchive;
+        ArchiveMgr::Reader _archive; // empty unless _fromArchive
+        uint32_t _stride = 1;
+        uint32_t _emitted = 0;
+        char _scratch[48]; // the record being copied out
+        uint8_t _len = 0;
+        uint8_t _pos = 0;
+    };
+
+    /// Write the history as CSV ("timestamp,distance_cm" header) to `out`.
+    void writeCSV(Print& out);
+
+    /// Write the history as `{"unit":"cm","data":[{"ts":..,"val":..},..],"next":..}`.
+    void writeJSON(Print& out);
 
-    /// Returns the number of entries currently stored.
+    /// Returns the number of entries currently stored. O(1).
     int getEntryCount();
 }
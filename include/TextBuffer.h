@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include <stdarg.h>
+
+/// Fixed-capacity text built with print()/printf() into storage held by the
+/// object itself (stack or static), for paths that run often enough that a
+/// heap String per call would fragment the heap over days of uptime.
+///
+/// Output beyond N - 1 characters is dropped and reported by truncated();
+/// the text is always NUL-terminated.
+template <size_t N> class TextBuffer : public Print {
+public:
+  TextBuffer() { clear(); }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+
+  size_t write(const uint8_t *data, size_t size) override {
+    size_t room = N - 1 - _len;
+    if (size > room) {
+      size = room;
+      _truncated = true;
+    }
+    memcpy(_buf + _len, data, size);
+    _len += size;
+    _buf[_len] = '\0';
+    return size;
+  }
+  using Print::write;
+
+  /// Formats straight into the buffer (Print::printf may allocate for long
+  /// output).
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    size_t room = N - _len;
+    int n = vsnprintf(_buf + _len, room, format, args);
+    va_end(args);
+    if (n < 0)
+      return 0;
+    if ((size_t)n >= room) {
+      n = room - 1;
+      _truncated = true;
+    }
+    _len += n;
+    return n;
+  }
+
+  void clear() {
+    _len = 0;
+    _buf[0] = '\0';
+    _truncated = false;
+  }
+
+  const char *c_str() const { return _buf; }
+  size_t length() const { return _len; }
+  bool truncated() const { return _truncated; }
+
+private:
+  char _buf[N];
+  size_t _len;
+  bool _truncated;
+};
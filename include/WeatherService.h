@@ -13,6 +13,7 @@ namespace WeatherSvc {
     /// True if the latest forecast contains "Rain" or "Thunderstorm".
     bool isRainExpected();
 
-    /// Human-readable forecast description (e.g. "Clear", "Rain").
-    String getForecastDescription();
+    /// Human-readable forecast description (e.g. "Clear", "Rain"). Points
+    /// at a static buffer that the next update() overwrites.
+    const char* getForecastDescription();
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
+#include "StorageManager.h"
 
 /// Sets up HTTP routes and WebSocket handler on the given server.
 namespace WebHandler {
@@ -8,9 +9,18 @@ namespace WebHandler {
     void begin(AsyncWebServer& server, AsyncWebSocket& ws);
 
     /// Broadcast current sensor data + thresholds to all WS clients.
-    void broadcastLevel(AsyncWebSocket& ws, float distanceCm,
+    /// Only changed fields are sent ("type":"delta"), with a full frame
+    /// ("type":"full") on connect and every WS_KEYFRAME_INTERVAL_MS.
+    /// Returns true if a frame was queued.
+    bool broadcastLevel(AsyncWebSocket& ws, float distanceCm,
                         float warningThr, float alarmThr,
-                        bool rainExpected, const String& forecast);
+                        bool rainExpected, const char* forecast);
+
+    /// Tell WS clients a reading was logged ("type":"history") so they can
+    /// extend their chart without refetching. A client whose cursor isn't
+    /// `seq` has missed one and should fetch `/api/history?since=<cursor>`.
+    void broadcastHistoryAppend(AsyncWebSocket& ws,
+                                const StorageMgr::Reading& r, uint32_t seq);
 
     /// Clean up disconnected WS clients (call periodically).
     void cleanupClients(AsyncWebSocket& ws);
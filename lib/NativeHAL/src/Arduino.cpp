@@ -0,0 +1,254 @@
+#include "Arduino.h"
+#include "NativeHal.h"
+#include <chrono>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+void NativeHal::setSerialEnabled(bool enabled) { Serial.muted = !enabled; }
+
+// ─── Virtual clock ──────────────────────────────────────────────────────────
+static const auto bootTime = std::chrono::steady_clock::now();
+static uint64_t skewUs = 0; // time added by delay() and advanceMicros()
+
+static uint64_t nowUs() {
+  auto real = std::chrono::steady_clock::now() - bootTime;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(real)
+             .count() +
+         skewUs;
+}
+
+unsigned long millis() { return (unsigned long)(nowUs() / 1000ULL); }
+unsigned long micros() { return (unsigned long)nowUs(); }
+void delay(unsigned long ms) { skewUs += (uint64_t)ms * 1000ULL; }
+void delayMicroseconds(unsigned int us) { skewUs += us; }
+void yield() {}
+
+void NativeHal::advanceMicros(uint64_t us) { skewUs += us; }
+
+// ─── GPIO and echo simulation ───────────────────────────────────────────────
+static const uint8_t PIN_COUNT = 17;
+static uint8_t pinLevel[PIN_COUNT];
+static void (*pinIsr[PIN_COUNT])() = {};
+
+static int echoTrig = -1;
+static int echoPin = -1;
+static float echoCm = -1.0f;
+static unsigned long pendingPulseUs = 0; // consumed by pulseIn()
+
+void NativeHal::setEcho(uint8_t trigPin, uint8_t echo, float distanceCm) {
+  echoTrig = trigPin;
+  echoPin = echo;
+  echoCm = distanceCm;
+}
+
+static void setLevel(uint8_t pin, uint8_t value) {
+  if (pin >= PIN_COUNT || pinLevel[pin] == value)
+    return;
+  pinLevel[pin] = value;
+  if (pinIsr[pin])
+    pinIsr[pin]();
+}
+
+static void emitEcho() {
+  if (echoPin < 0 || echoCm < 0)
+    return;
+  // Round trip at 0.0343 cm/µs, the inverse of SensorMgr's conversion
+  unsigned long widthUs = (unsigned long)lroundf(echoCm * 2.0f / 0.0343f);
+  setLevel(echoPin, HIGH);
+  skewUs += widthUs;
+  setLevel(echoPin, LOW);
+  pendingPulseUs = widthUs;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= PIN_COUNT)
+    return;
+  bool falling = pinLevel[pin] == HIGH && value == LOW;
+  pinLevel[pin] = value;
+  if (falling && pin == echoTrig)
+    emitEcho();
+}
+
+int digitalRead(uint8_t pin) { return pin < PIN_COUNT ? pinLevel[pin] : LOW; }
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeoutUs) {
+  unsigned long width = pendingPulseUs;
+  pendingPulseUs = 0;
+  if ((int)pin != echoPin || state != HIGH || width > timeoutUs)
+    return 0;
+  return width;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+  if (pin < PIN_COUNT)
+    pinIsr[pin] = isr;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < PIN_COUNT)
+    pinIsr[pin] = nullptr;
+}
+
+long random(long max) { return max > 0 ? rand() % max : 0; }
+long random(long min, long max) {
+  return max > min ? min + rand() % (max - min) : min;
+}
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+
+// ─── ESP ────────────────────────────────────────────────────────────────────
+// Values of a freshly booted D1 mini, so heap checks behave as on the device
+uint32_t EspClass::getFreeHeap() { return 45000; }
+uint32_t EspClass::getMaxFreeBlockSize() { return 40000; }
+uint8_t EspClass::getHeapFragmentation() { return 0; }
+
+void EspClass::restart() {
+  Serial.println("[HAL] ESP.restart() requested, exiting.");
+  fflush(stdout);
+  exit(0);
+}
+
+static uint32_t rtcUserMemory[128];
+static rst_info resetInfo = {REASON_DEFAULT_RST, 0, 0, 0, 0, 0, 0};
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data,
+                                 size_t size) {
+  if (offset * 4 + size > sizeof(rtcUserMemory))
+    return false;
+  memcpy(data, (uint8_t *)rtcUserMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data,
+                                  size_t size) {
+  if (offset * 4 + size > sizeof(rtcUserMemory))
+    return false;
+  memcpy((uint8_t *)rtcUserMemory + offset * 4, data, size);
+  return true;
+}
+
+void EspClass::deepSleep(uint64_t timeUs, RFMode) {
+  Serial.printf("[HAL] ESP.deepSleep(%llu us) requested, exiting.\n",
+                (unsigned long long)timeUs);
+  fflush(stdout);
+  exit(0);
+}
+
+rst_info *EspClass::getResetInfoPtr() { return &resetInfo; }
+
+// ─── Print / Stream / String ────────────────────────────────────────────────
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char stackBuf[128];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(stackBuf, sizeof(stackBuf), format, args);
+  va_end(args);
+  if (len < 0)
+    return 0;
+  if ((size_t)len < sizeof(stackBuf))
+    return write((const uint8_t *)stackBuf, len);
+
+  std::vector<char> heapBuf(len + 1);
+  va_start(args, format);
+  vsnprintf(heapBuf.data(), heapBuf.size(), format, args);
+  va_end(args);
+  return write((const uint8_t *)heapBuf.data(), len);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = read();
+    if (c < 0)
+      break;
+    buffer[n++] = (char)c;
+  }
+  return n;
+}
+
+String Stream::readString() {
+  String s;
+  int c;
+  while ((c = read()) >= 0)
+    s += (char)c;
+  return s;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String s;
+  int c;
+  while ((c = read()) >= 0 && c != terminator)
+    s += (char)c;
+  return s;
+}
+
+void String::replace(const String &find, const String &with) {
+  if (find._s.empty())
+    return;
+  size_t p = 0;
+  while ((p = _s.find(find._s, p)) != std::string::npos) {
+    _s.replace(p, find._s.size(), with._s);
+    p += with._s.size();
+  }
+}
+
+void String::trim() {
+  size_t first = _s.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) {
+    _s.clear();
+    return;
+  }
+  size_t last = _s.find_last_not_of(" \t\r\n");
+  _s = _s.substr(first, last - first + 1);
+}
+
+void String::toLowerCase() {
+  for (char &c : _s)
+    c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (char &c : _s)
+    c = (char)toupper((unsigned char)c);
+}
+
+void String::fromLong(long v, unsigned char base) {
+  if (base == 10) {
+    _s = std::to_string(v);
+    return;
+  }
+  fromULong((unsigned long)v, base);
+}
+
+void String::fromULong(unsigned long v, unsigned char base) {
+  if (base == 10) {
+    _s = std::to_string(v);
+    return;
+  }
+  char buf[8 * sizeof(long) + 1];
+  char *p = buf + sizeof(buf);
+  *--p = 0;
+  do {
+    unsigned digit = v % base;
+    *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    v /= base;
+  } while (v);
+  _s = p;
+}
+
+void String::fromDouble(double v, unsigned char decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  _s = buf;
+}
@@ -0,0 +1,121 @@
+#pragma once
+// Host build of the Arduino core API used by the firmware. Time is a
+// virtual clock: delay() advances it instead of sleeping, so code that waits
+// on the sensor or between retries runs at full speed on the host.
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(p) (p)
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define digitalPinToInterrupt(p) (p)
+
+// ── Timing ──────────────────────────────────────────────────────────────
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ── GPIO / interrupts ───────────────────────────────────────────────────
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state,
+                      unsigned long timeoutUs = 1000000UL);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ── Serial (logs go to stderr so stdout stays machine-readable) ────────
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    return muted ? size : fwrite(buffer, 1, size, stderr);
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+
+  bool muted = false; // see NativeHal::setSerialEnabled
+};
+extern HardwareSerial Serial;
+
+// ── ESP ─────────────────────────────────────────────────────────────────
+enum RFMode { RF_DEFAULT = 0, RF_CAL = 1, RF_NO_CAL = 2, RF_DISABLED = 4 };
+#define WAKE_RF_DEFAULT RF_DEFAULT
+#define WAKE_RF_DISABLED RF_DISABLED
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1, epc2, epc3, excvaddr, depc;
+};
+
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint8_t getHeapFragmentation();
+  uint32_t getChipId() { return 0x00F100D; }
+  uint32_t getCycleCount() { return (uint32_t)(micros() * 80UL); }
+  String getResetReason() { return "Power On"; }
+  void restart();
+
+  /// 512 bytes of user RTC memory; offsets are in 4-byte blocks.
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+  /// Ends the process, like restart(); RTC memory does not survive it.
+  void deepSleep(uint64_t timeUs, RFMode mode = RF_DEFAULT);
+  rst_info *getResetInfoPtr();
+};
+extern EspClass ESP;
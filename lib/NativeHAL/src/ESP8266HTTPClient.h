@@ -0,0 +1,38 @@
+#pragma once
+#include <WiFiClient.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+
+/// HTTPClient stand-in: requests go through the supplied WiFiClient, which
+/// never connects on the host, and report the core's connection error codes.
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url);
+  void end();
+
+  void setReuse(bool reuse) { _reuse = reuse; }
+  void setTimeout(uint16_t timeoutMs) { _timeout = timeoutMs; }
+  void addHeader(const String &, const String &) {}
+
+  int GET() { return sendRequest("GET"); }
+  int POST(const String &payload) {
+    return sendRequest("POST", payload.length());
+  }
+  int sendRequest(const char *method, size_t payloadSize = 0);
+
+  int getSize() { return -1; }
+  String getString() { return String(); }
+  WiFiClient &getStream() { return *_client; }
+  bool connected() { return _client && _client->connected(); }
+
+  static String errorToString(int error);
+
+private:
+  WiFiClient *_client = nullptr;
+  String _host;
+  uint16_t _port = 80;
+  bool _reuse = false;
+  uint16_t _timeout = 5000;
+};
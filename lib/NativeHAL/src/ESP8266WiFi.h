@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+};
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0)
+      : _octets{a, b, c, d} {}
+  String toString() const;
+
+private:
+  uint8_t _octets[4];
+};
+
+/// Station interface; the link state is set with NativeHal::setWiFiConnected.
+class ESP8266WiFiClass {
+public:
+  wl_status_t status();
+  bool mode(WiFiMode_t) { return true; }
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+  wl_status_t begin(const String &ssid, const String &passphrase) {
+    return begin(ssid.c_str(), passphrase.c_str());
+  }
+  bool disconnect(bool wifiOff = false);
+  bool reconnect();
+  bool forceSleepBegin(uint32_t sleepUs = 0);
+  bool forceSleepWake();
+  IPAddress localIP();
+  int32_t RSSI();
+};
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace NativeHal {
+/// Open host file plus what the LittleFS cost model needs to know about it.
+struct HostFile {
+  FILE *f;
+  bool append;
+  size_t dirtyFrom = SIZE_MAX; // lowest offset written since the last sync
+
+  HostFile(FILE *f, bool append) : f(f), append(append) {}
+  HostFile(const HostFile &) = delete;
+  ~HostFile();
+};
+} // namespace NativeHal
+
+/// File handle on the host filesystem. Copies share the underlying FILE,
+/// like the ESP8266 core's reference-counted File.
+class File : public Stream {
+public:
+  File() {}
+  File(FILE *f, bool append, const String &name)
+      : _h(std::make_shared<NativeHal::HostFile>(f, append)),
+        _f(_h, f), _name(name) {}
+
+  explicit operator bool() const { return (bool)_f; }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  bool truncate(uint32_t size);
+
+  int available() override { return _f ? (int)(size() - position()) : 0; }
+  int read() override { return _f ? fgetc(_f.get()) : -1; }
+  int peek() override;
+  size_t read(uint8_t *buffer, size_t size) {
+    return _f ? fread(buffer, 1, size, _f.get()) : 0;
+  }
+
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+    return _f && fseek(_f.get(), (long)pos, (int)mode) == 0;
+  }
+  size_t position() const { return _f ? (size_t)ftell(_f.get()) : 0; }
+  size_t size() const;
+  const char *name() const { return _name.c_str(); }
+
+  void flush() override;
+  void close() {
+    _f.reset();
+    _h.reset();
+  }
+
+private:
+  std::shared_ptr<NativeHal::HostFile> _h;
+  std::shared_ptr<FILE> _f; // aliases _h
+  String _name;
+};
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+namespace fs {
+/// Filesystem rooted in a host directory (see NativeHal::setFsRoot).
+class FS {
+public:
+  bool begin();
+  void end() {}
+  bool format();
+  bool info(FSInfo &info);
+
+  File open(const char *path, const char *mode);
+  File open(const String &path, const char *mode) {
+    return open(path.c_str(), mode);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *from, const char *to);
+};
+} // namespace fs
+
+using fs::FS;
@@ -0,0 +1,163 @@
+#include "LittleFS.h"
+#include "NativeHal.h"
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+namespace stdfs = std::filesystem;
+
+fs::FS LittleFS;
+
+// Same geometry as the d1_mini 1 MB LittleFS partition
+static const size_t FS_TOTAL_BYTES = 1024 * 1024;
+static const size_t FS_BLOCK_SIZE = 8192;
+
+static std::string rootDir;
+static uint64_t programmedBytes = 0;
+
+uint64_t NativeHal::fsProgrammedBytes() { return programmedBytes; }
+
+/// Charge a sync of `f` to the cost model.
+static void commit(NativeHal::HostFile &h) {
+  if (h.dirtyFrom == SIZE_MAX)
+    return;
+  fflush(h.f);
+  long pos = ftell(h.f);
+  fseek(h.f, 0, SEEK_END);
+  size_t end = (size_t)ftell(h.f);
+  fseek(h.f, pos, SEEK_SET);
+  size_t from = h.dirtyFrom / FS_BLOCK_SIZE * FS_BLOCK_SIZE;
+  if (end > from)
+    programmedBytes += end - from;
+  h.dirtyFrom = SIZE_MAX;
+}
+
+NativeHal::HostFile::~HostFile() {
+  commit(*this);
+  fclose(f);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  if (!_f)
+    return 0;
+  size_t pos = _h->append ? this->size() : position();
+  if (pos < _h->dirtyFrom)
+    _h->dirtyFrom = pos;
+  return fwrite(buffer, 1, size, _f.get());
+}
+
+bool File::truncate(uint32_t size) {
+  if (!_f)
+    return false;
+  fflush(_f.get());
+  if (ftruncate(fileno(_f.get()), size) != 0)
+    return false;
+  if (size < _h->dirtyFrom)
+    _h->dirtyFrom = size;
+  return true;
+}
+
+void File::flush() {
+  if (_h)
+    commit(*_h);
+}
+
+void NativeHal::setFsRoot(const char *dir) { rootDir = dir; }
+
+const char *NativeHal::fsRoot() {
+  if (rootDir.empty()) {
+    const char *env = getenv("FLOOD_FS_ROOT");
+    rootDir = env ? env : "native_fs";
+  }
+  return rootDir.c_str();
+}
+
+static std::string hostPath(const char *path) {
+  return std::string(NativeHal::fsRoot()) + (path[0] == '/' ? "" : "/") +
+         path;
+}
+
+int File::peek() {
+  if (!_f)
+    return -1;
+  int c = fgetc(_f.get());
+  if (c >= 0)
+    ungetc(c, _f.get());
+  return c;
+}
+
+size_t File::size() const {
+  if (!_f)
+    return 0;
+  long pos = ftell(_f.get());
+  fseek(_f.get(), 0, SEEK_END);
+  long end = ftell(_f.get());
+  fseek(_f.get(), pos, SEEK_SET);
+  return (size_t)end;
+}
+
+bool fs::FS::begin() {
+  std::error_code ec;
+  stdfs::create_directories(NativeHal::fsRoot(), ec);
+  return !ec;
+}
+
+bool fs::FS::format() {
+  std::error_code ec;
+  stdfs::remove_all(NativeHal::fsRoot(), ec);
+  return begin();
+}
+
+bool fs::FS::info(FSInfo &info) {
+  size_t used = 0;
+  std::error_code ec;
+  for (auto &entry : stdfs::recursive_directory_iterator(NativeHal::fsRoot(),
+                                                         ec)) {
+    if (entry.is_regular_file())
+      used += (entry.file_size() + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE *
+              FS_BLOCK_SIZE;
+  }
+  info.totalBytes = FS_TOTAL_BYTES;
+  info.usedBytes = used;
+  info.blockSize = FS_BLOCK_SIZE;
+  info.pageSize = 256;
+  info.maxOpenFiles = 5;
+  info.maxPathLength = 32;
+  return true;
+}
+
+File fs::FS::open(const char *path, const char *mode) {
+  // Arduino modes map onto stdio; always binary so seeks are byte exact
+  std::string m = mode;
+  const char *stdioMode = m == "r"    ? "rb"
+                          : m == "r+" ? "r+b"
+                          : m == "w"  ? "wb"
+                          : m == "w+" ? "w+b"
+                          : m == "a"  ? "ab"
+                          : m == "a+" ? "a+b"
+                                      : nullptr;
+  if (!stdioMode)
+    return File();
+
+  std::string full = hostPath(path);
+  std::error_code ec;
+  stdfs::create_directories(stdfs::path(full).parent_path(), ec);
+  FILE *f = fopen(full.c_str(), stdioMode);
+  return f ? File(f, m[0] == 'a', path) : File();
+}
+
+bool fs::FS::exists(const char *path) {
+  std::error_code ec;
+  return stdfs::exists(hostPath(path), ec);
+}
+
+bool fs::FS::remove(const char *path) {
+  std::error_code ec;
+  return stdfs::remove(hostPath(path), ec);
+}
+
+bool fs::FS::rename(const char *from, const char *to) {
+  std::error_code ec;
+  stdfs::rename(hostPath(from), hostPath(to), ec);
+  return !ec;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+/// Hooks for driving the host shims from benchmarks and experiments.
+/// Not available on the device.
+namespace NativeHal {
+    /// Directory that backs LittleFS (created on LittleFS.begin()).
+    /// Defaults to $FLOOD_FS_ROOT or ./native_fs.
+    void setFsRoot(const char* dir);
+    const char* fsRoot();
+
+    /// Flash bytes LittleFS would have programmed so far. Data written at
+    /// offset X of a file is committed on flush/close by copying the file
+    /// from the start of X's block to its end (LittleFS stores files as
+    /// copy-on-write block lists), so an append costs at most one block
+    /// while a write near the start of a large file costs the whole file.
+    uint64_t fsProgrammedBytes();
+
+    /// Silence Serial (e.g. around timed sections). Output goes to stderr.
+    void setSerialEnabled(bool enabled);
+
+    /// Move the virtual clock forward without running anything.
+    void advanceMicros(uint64_t us);
+
+    /// Simulate an ultrasonic sensor: each falling edge on `trigPin` produces
+    /// an echo pulse on `echoPin` matching `distanceCm` (edges are delivered
+    /// to an attached interrupt and to pulseIn). A negative distance means no
+    /// echo at all.
+    void setEcho(uint8_t trigPin, uint8_t echoPin, float distanceCm);
+
+    /// Station link state reported by WiFi.status(). Sockets never connect
+    /// on the host, so this only controls whether callers try.
+    void setWiFiConnected(bool connected);
+    bool wifiConnected();
+}
@@ -0,0 +1,92 @@
+#include "Preferences.h"
+#include <map>
+#include <string>
+
+typedef std::map<std::string, std::string> Namespace;
+
+static std::map<std::string, Namespace> &store() {
+  static std::map<std::string, Namespace> namespaces;
+  return namespaces;
+}
+
+bool Preferences::begin(const char *name, bool readOnly) {
+  _name = name;
+  _open = true;
+  _readOnly = readOnly;
+  return true;
+}
+
+void Preferences::end() { _open = false; }
+
+static const std::string *lookup(const String &ns, const char *key) {
+  auto n = store().find(ns.c_str());
+  if (n == store().end())
+    return nullptr;
+  auto v = n->second.find(key);
+  return v == n->second.end() ? nullptr : &v->second;
+}
+
+bool Preferences::isKey(const char *key) {
+  return _open && lookup(_name, key) != nullptr;
+}
+
+bool Preferences::remove(const char *key) {
+  return writable() && store()[_name.c_str()].erase(key) > 0;
+}
+
+bool Preferences::clear() {
+  if (!writable())
+    return false;
+  store()[_name.c_str()].clear();
+  return true;
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+  const std::string *v = _open ? lookup(_name, key) : nullptr;
+  return v ? String(*v) : defaultValue;
+}
+
+size_t Preferences::putString(const char *key, const String &value) {
+  if (!writable())
+    return 0;
+  store()[_name.c_str()][key] = value.c_str();
+  return value.length();
+}
+
+// Numbers are kept as text; "%.9g" round-trips every float exactly
+float Preferences::getFloat(const char *key, float defaultValue) {
+  const std::string *v = _open ? lookup(_name, key) : nullptr;
+  return v ? strtof(v->c_str(), nullptr) : defaultValue;
+}
+
+size_t Preferences::putFloat(const char *key, float value) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%.9g", value);
+  return putString(key, buf) ? sizeof(float) : 0;
+}
+
+int32_t Preferences::getInt(const char *key, int32_t defaultValue) {
+  const std::string *v = _open ? lookup(_name, key) : nullptr;
+  return v ? (int32_t)strtol(v->c_str(), nullptr, 10) : defaultValue;
+}
+
+size_t Preferences::putInt(const char *key, int32_t value) {
+  return putString(key, String((long)value)) ? sizeof(value) : 0;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+  const std::string *v = _open ? lookup(_name, key) : nullptr;
+  return v ? (uint32_t)strtoul(v->c_str(), nullptr, 10) : defaultValue;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+  return putString(key, String((unsigned long)value)) ? sizeof(value) : 0;
+}
+
+bool Preferences::getBool(const char *key, bool defaultValue) {
+  return getUInt(key, defaultValue ? 1 : 0) != 0;
+}
+
+size_t Preferences::putBool(const char *key, bool value) {
+  return putUInt(key, value ? 1 : 0) ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+
+/// In-memory Preferences: namespaces live for the lifetime of the process.
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false);
+  void end();
+
+  bool isKey(const char *key);
+  bool remove(const char *key);
+  bool clear();
+
+  String getString(const char *key, const String &defaultValue = String());
+  size_t putString(const char *key, const String &value);
+  float getFloat(const char *key, float defaultValue = NAN);
+  size_t putFloat(const char *key, float value);
+  int32_t getInt(const char *key, int32_t defaultValue = 0);
+  size_t putInt(const char *key, int32_t value);
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+  size_t putUInt(const char *key, uint32_t value);
+  bool getBool(const char *key, bool defaultValue = false);
+  size_t putBool(const char *key, bool value);
+
+private:
+  bool writable() const { return _open && !_readOnly; }
+
+  String _name;
+  bool _open = false;
+  bool _readOnly = true;
+};
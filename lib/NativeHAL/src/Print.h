@@ -0,0 +1,45 @@
+#pragma once
+#include "WString.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+/// Byte sink with the Arduino print()/printf() helpers on top of write().
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *s) {
+    return s ? write((const uint8_t *)s, strlen(s)) : 0;
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v, int base = DEC) { return print(String(v, base)); }
+  size_t print(unsigned v, int base = DEC) { return print(String(v, base)); }
+  size_t print(long v, int base = DEC) { return print(String(v, base)); }
+  size_t print(unsigned long v, int base = DEC) {
+    return print(String(v, base));
+  }
+  size_t print(double v, int digits = 2) { return print(String(v, digits)); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) {
+    size_t n = print(v);
+    return n + println();
+  }
+
+  size_t printf(const char *format, ...)
+      __attribute__((format(printf, 2, 3)));
+
+  virtual void flush() {}
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "Print.h"
+
+/// Readable byte source. read() returns -1 when no data is available.
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    return readBytes((char *)buffer, length);
+  }
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  unsigned long _timeout = 1000;
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/// Arduino `String` backed by std::string. Covers the subset the firmware
+/// and ArduinoJson use; semantics follow the ESP8266 core.
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v, unsigned char base = 10) { fromLong(v, base); }
+  explicit String(unsigned v, unsigned char base = 10) { fromULong(v, base); }
+  explicit String(long v, unsigned char base = 10) { fromLong(v, base); }
+  explicit String(unsigned long v, unsigned char base = 10) {
+    fromULong(v, base);
+  }
+  explicit String(float v, unsigned char decimals = 2) {
+    fromDouble(v, decimals);
+  }
+  explicit String(double v, unsigned char decimals = 2) {
+    fromDouble(v, decimals);
+  }
+
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  const char *c_str() const { return _s.c_str(); }
+  bool reserve(unsigned int size) {
+    _s.reserve(size);
+    return true;
+  }
+
+  bool concat(const String &s) {
+    _s += s._s;
+    return true;
+  }
+  bool concat(const char *s) {
+    if (!s)
+      return false;
+    _s += s;
+    return true;
+  }
+  bool concat(const char *s, unsigned int len) {
+    if (!s)
+      return false;
+    _s.append(s, len);
+    return true;
+  }
+  bool concat(char c) {
+    _s += c;
+    return true;
+  }
+  template <typename T> bool concat(T v) { return concat(String(v)); }
+
+  String &operator+=(const String &s) { return concat(s), *this; }
+  String &operator+=(const char *s) { return concat(s), *this; }
+  String &operator+=(char c) { return concat(c), *this; }
+  template <typename T> String &operator+=(T v) { return concat(v), *this; }
+
+  bool equals(const String &s) const { return _s == s._s; }
+  bool operator==(const String &s) const { return _s == s._s; }
+  bool operator==(const char *s) const { return _s == (s ? s : ""); }
+  bool operator!=(const String &s) const { return !(*this == s); }
+  bool operator!=(const char *s) const { return !(*this == s); }
+  bool operator<(const String &s) const { return _s < s._s; }
+
+  char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char operator[](unsigned int i) const { return charAt(i); }
+  char &operator[](unsigned int i) { return _s[i]; }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    return pos(_s.find(c, from));
+  }
+  int indexOf(const String &s, unsigned int from = 0) const {
+    return pos(_s.find(s._s, from));
+  }
+  int lastIndexOf(char c) const { return pos(_s.rfind(c)); }
+  bool startsWith(const String &s) const { return _s.rfind(s._s, 0) == 0; }
+  bool endsWith(const String &s) const {
+    return _s.size() >= s._s.size() &&
+           _s.compare(_s.size() - s._s.size(), s._s.size(), s._s) == 0;
+  }
+
+  String substring(unsigned int from) const {
+    return from >= _s.size() ? String() : String(_s.substr(from));
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+      unsigned int t = from;
+      from = to;
+      to = t;
+    }
+    return from >= _s.size() ? String() : String(_s.substr(from, to - from));
+  }
+
+  void replace(const String &find, const String &with);
+  void remove(unsigned int index) { _s.erase(index); }
+  void remove(unsigned int index, unsigned int count) {
+    _s.erase(index, count);
+  }
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(_s.c_str(), nullptr); }
+  double toDouble() const { return strtod(_s.c_str(), nullptr); }
+
+private:
+  static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+  void fromLong(long v, unsigned char base);
+  void fromULong(unsigned long v, unsigned char base);
+  void fromDouble(double v, unsigned char decimals);
+
+  std::string _s;
+};
+
+inline String operator+(const String &a, const String &b) {
+  String r(a);
+  r.concat(b);
+  return r;
+}
+inline String operator+(const String &a, const char *b) {
+  String r(a);
+  r.concat(b);
+  return r;
+}
+inline String operator+(const char *a, const String &b) {
+  String r(a);
+  r.concat(b);
+  return r;
+}
+template <typename T> String operator+(const String &a, T v) {
+  String r(a);
+  r.concat(v);
+  return r;
+}
@@ -0,0 +1,90 @@
+#include "ESP8266HTTPClient.h"
+#include "ESP8266WiFi.h"
+#include "NativeHal.h"
+
+ESP8266WiFiClass WiFi;
+
+static bool linkUp = true;
+
+void NativeHal::setWiFiConnected(bool connected) { linkUp = connected; }
+bool NativeHal::wifiConnected() { return linkUp; }
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _octets[0], _octets[1],
+           _octets[2], _octets[3]);
+  return buf;
+}
+
+wl_status_t ESP8266WiFiClass::status() {
+  return linkUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *, const char *) {
+  return status();
+}
+
+bool ESP8266WiFiClass::disconnect(bool) {
+  linkUp = false;
+  return true;
+}
+
+bool ESP8266WiFiClass::reconnect() {
+  linkUp = true;
+  return true;
+}
+
+bool ESP8266WiFiClass::forceSleepBegin(uint32_t) {
+  linkUp = false;
+  return true;
+}
+
+bool ESP8266WiFiClass::forceSleepWake() { return true; }
+
+IPAddress ESP8266WiFiClass::localIP() {
+  return linkUp ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+int32_t ESP8266WiFiClass::RSSI() { return linkUp ? -60 : 31; }
+
+int WiFiClient::connect(const char *, uint16_t) { return 0; }
+
+// ─── HTTPClient ─────────────────────────────────────────────────────────────
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  int hostStart = url.indexOf("://");
+  if (hostStart < 0)
+    return false;
+  hostStart += 3;
+  int pathStart = url.indexOf('/', hostStart);
+  _host = pathStart < 0 ? url.substring(hostStart)
+                        : url.substring(hostStart, pathStart);
+  _port = url.startsWith("https") ? 443 : 80;
+  _client = &client;
+  return true;
+}
+
+void HTTPClient::end() {
+  if (_client && !_reuse)
+    _client->stop();
+  _client = nullptr;
+}
+
+int HTTPClient::sendRequest(const char *, size_t) {
+  if (!_client)
+    return HTTPC_ERROR_NOT_CONNECTED;
+  if (!_client->connected() && !_client->connect(_host.c_str(), _port))
+    return HTTPC_ERROR_CONNECTION_FAILED;
+  return HTTPC_ERROR_NOT_CONNECTED; // unreachable on the host
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+  case HTTPC_ERROR_CONNECTION_FAILED:
+    return "connection failed";
+  case HTTPC_ERROR_NOT_CONNECTED:
+    return "not connected";
+  default:
+    return String();
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+
+class Client : public Stream {
+public:
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  virtual explicit operator bool() { return connected(); }
+};
+
+/// TCP client stand-in. The host build has no network: connect() always
+/// fails, so callers exercise their error and retry paths.
+class WiFiClient : public Client {
+public:
+  int connect(const char *host, uint16_t port) override;
+  uint8_t connected() override { return 0; }
+  void stop() override {}
+
+  size_t write(uint8_t) override { return 0; }
+  size_t write(const uint8_t *, size_t) override { return 0; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int read(uint8_t *, size_t) { return -1; }
+  int peek() override { return -1; }
+
+  void setNoDelay(bool) {}
+  void setTimeout(unsigned long timeoutMs) { Stream::setTimeout(timeoutMs); }
+};
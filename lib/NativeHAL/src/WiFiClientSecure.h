@@ -0,0 +1,18 @@
+#pragma once
+#include <WiFiClient.h>
+
+namespace BearSSL {
+class Session {};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setSession(Session *) {}
+  void setBufferSizes(int, int) {}
+  bool probeMaxFragmentLength(const char *, uint16_t, uint16_t) {
+    return false;
+  }
+};
+} // namespace BearSSL
+
+using BearSSL::WiFiClientSecure;
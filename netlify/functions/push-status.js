@@ -79,6 +79,34 @@ async function fetchStationWeather(stationKey, weatherStore) {
 }
 
 
+/**
+ * Expand a delta-encoded reading batch sent by the ESP.
+ * Format: { t0, v0, scale, dt: [...], dv: [...] } where t0 is an epoch in
+ * seconds, v0 the first value in 1/scale cm and dt/dv the per-sample deltas.
+ * Timestamps from a device without NTP (t0 not a plausible epoch) are
+ * re-anchored so the last sample lands on "now".
+ */
+function decodeBatch(batch) {
+    if (!batch || !Number.isFinite(batch.t0) || !Number.isFinite(batch.v0)) return [];
+    const scale = batch.scale || 10;
+    const dt = Array.isArray(batch.dt) ? batch.dt : [];
+    const dv = Array.isArray(batch.dv) ? batch.dv : [];
+
+    let t = batch.t0;
+    let v = batch.v0;
+    const readings = [{ t, val: v / scale }];
+    for (let i = 0; i < Math.min(dt.length, dv.length); i++) {
+        t += dt[i];
+        v += dv[i];
+        readings.push({ t, val: v / scale });
+    }
+
+    const lastT = readings[readings.length - 1].t;
+    const shift = batch.t0 < 1000000000 ? Math.floor(Date.now() / 1000) - lastT : 0;
+    return readings.map(r => ({ ts: new Date((r.t + shift) * 1000).toISOString(), val: r.val }));
+}
+
+
 export default async (req, context) => {
     const corsHeaders = {
         'Access-Control-Allow-Origin': '*',
@@ -126,7 +154,7 @@ export default async (req, context) => {
 
         // ESP only sends: distance, status, station, river
         // UI additionally sends: warning, alarm, intervals, isUiUpdate, simWeatherTier
-        let { distance, warning, alarm, status, station = "Antwerpen", river = "Schelde", intervals, isUiUpdate } = body;
+        let { distance, warning, alarm, status, station = "Antwerpen", river = "Schelde", intervals, isUiUpdate, batch } = body;
         const stationKey = station.toLowerCase().trim();
 
         console.log(`[Cloud] Normalized Key: "${stationKey}" (isUiUpdate: ${!!isUiUpdate})`);
@@ -192,7 +220,17 @@ export default async (req, context) => {
         history = history.filter(e => e.val !== undefined && e.val > 0);
 
         // Only store valid readings in history (filter out sensor errors: -1, 0, undefined)
-        if (isValidReading) {
+        if (batch) {
+            // Batched upload: the batch already contains the latest reading
+            const readings = decodeBatch(batch).filter(r => r.val > 0);
+            console.log(`[History] Batch of ${readings.length} readings`);
+            // The outbox replays at least once: a resent reading replaces
+            // the stored one with the same timestamp instead of adding to it
+            const byTs = new Map(history.map(e => [e.ts, e]));
+            for (const r of readings) byTs.set(r.ts, r);
+            history = [...byTs.values()];
+            history.sort((a, b) => (a.ts < b.ts ? -1 : a.ts > b.ts ? 1 : 0));
+        } else if (isValidReading) {
             history.push({ ts: sensorData.lastSeen, val: distance });
         } else {
             console.warn(`[History] Skipping invalid distance reading: ${distance}`);
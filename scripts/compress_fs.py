@@ -0,0 +1,83 @@
+# PlatformIO pre-script: builds the LittleFS image from a compressed copy
+# of data/ instead of data/ itself.
+#
+#   data/index.html    -> /index.html.gz       (the HTML shell, revalidated by ETag)
+#   data/js/chart.js   -> /a/chart.1a2b3c4d.js.gz
+#
+# Every other file gets a content hash in its name and moves to /a/, which
+# the firmware serves as immutable; references to it in the HTML are
+# rewritten to the hashed name. Output is deterministic (gzip mtime 0), so
+# an unchanged dashboard yields an identical image.
+#
+# Used by: extra_scripts = pre:scripts/compress_fs.py
+
+import gzip
+import hashlib
+import os
+import re
+import shutil
+
+Import("env")  # noqa: F821 (provided by SCons)
+
+ASSET_DIR = "a"
+LFS_NAME_MAX = 31  # LittleFS limit per path component on the ESP8266
+
+
+def gz(data):
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def write(path, data):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def check_name(name):
+    if len(name) > LFS_NAME_MAX:
+        raise SystemExit("[fs] %s: name longer than %d characters" % (name, LFS_NAME_MAX))
+
+
+def build(src, out):
+    if os.path.isdir(out):
+        shutil.rmtree(out)
+    os.makedirs(out)
+
+    pages, renames = [], {}
+    for root, _, files in os.walk(src):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, src).replace(os.sep, "/")
+            if name.endswith(".html"):
+                pages.append(rel)
+                continue
+            with open(path, "rb") as f:
+                data = f.read()
+            stem, ext = os.path.splitext(name)
+            hashed = "%s.%s%s" % (stem, hashlib.sha256(data).hexdigest()[:8], ext)
+            if hashed in renames.values():
+                raise SystemExit("[fs] %s: clashes with another asset" % rel)
+            check_name(hashed + ".gz")
+            renames[rel] = hashed
+            write(os.path.join(out, ASSET_DIR, hashed + ".gz"), gz(data))
+
+    for rel in pages:
+        with open(os.path.join(src, rel), "r", encoding="utf-8") as f:
+            html = f.read()
+        for old, hashed in renames.items():
+            html = re.sub(r'((?:src|href)=["\'])/?%s(["\'])' % re.escape(old),
+                          r"\g<1>/%s/%s\g<2>" % (ASSET_DIR, hashed), html)
+        data = html.encode("utf-8")
+        check_name(os.path.basename(rel) + ".gz")
+        packed = gz(data)
+        write(os.path.join(out, rel + ".gz"), packed)
+        print("[fs] %s: %d -> %d bytes" % (rel, len(data), len(packed)))
+
+    for rel, hashed in renames.items():
+        print("[fs] %s -> /%s/%s.gz" % (rel, ASSET_DIR, hashed))
+
+
+src = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+out = os.path.join(env.subst("$BUILD_DIR"), "fsdata")  # noqa: F821
+build(src, out)
+env.Replace(PROJECT_DATA_DIR=out)  # noqa: F821
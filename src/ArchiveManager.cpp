@@ -0,0 +1,307 @@
+#include "ArchiveManager.h"
+#include "Config.h"
+#include "RingFile.h"
+#include "StorageManager.h"
+#include <LittleFS.h>
+
+struct BlockHeader {
+  uint32_t block; // block sequence number, as numbered by the RingFile
+  uint32_t firstEpoch;
+  uint32_t lastEpoch;
+  uint32_t firstSeq; // archive-wide number of the block's first reading
+  int32_t firstDeci; // first level in 0.1 cm
+  uint16_t count;
+  uint16_t used; // payload bytes
+};
+
+static const uint16_t PAYLOAD_SIZE = ARCHIVE_BLOCK_SIZE - sizeof(BlockHeader);
+
+struct Block {
+  BlockHeader hdr;
+  uint8_t payload[PAYLOAD_SIZE];
+};
+
+static_assert(sizeof(Block) == ARCHIVE_BLOCK_SIZE, "Block must fill a page");
+// Each reading after the first takes at least 2 bytes. The raw ring must hold
+// a full open block so a reboot can always replay it.
+static_assert(1 + PAYLOAD_SIZE / 2 < HISTORY_RING_CAPACITY,
+              "Open archive block must fit in the raw history ring");
+
+static RingFile ring(ARCHIVE_PATH, sizeof(Block), ARCHIVE_BLOCKS,
+                     ARCHIVE_SEGMENT_BYTES);
+static Block openBlock;     // being filled, written when full
+static uint32_t nextSeq = 0; // number the next reading will get
+static int32_t prevDelta = 0; // encoder state of the open block
+static int32_t prevDeci = 0;
+
+// ── Encoding ───────────────────────────────────────────────────────────────
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (v >> 31); }
+
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static uint8_t putVarint(uint8_t *p, uint32_t v) {
+  uint8_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+/// Returns the bytes consumed, 0 if `len` ends mid-varint.
+static uint8_t getVarint(const uint8_t *p, size_t len, uint32_t &v) {
+  v = 0;
+  for (uint8_t i = 0; i < len && i < 5; i++) {
+    v |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+    if (!(p[i] & 0x80))
+      return i + 1;
+  }
+  return 0;
+}
+
+// ── Block access (flash or the open block) ────────────────────────────────
+
+static uint32_t oldestBlock() { return ring.total() - ring.count(); }
+
+/// One past the newest block, counting the open one if it has readings.
+static uint32_t blockLimit() { return ring.total() + (openBlock.hdr.count ? 1 : 0); }
+
+static bool readHeader(uint32_t block, BlockHeader &h) {
+  if (block == ring.total()) {
+    h = openBlock.hdr;
+    return h.count > 0;
+  }
+  if (block < oldestBlock())
+    return false;
+  return ring.read(block - oldestBlock(), &h, 0, sizeof(h)) && h.block == block;
+}
+
+static size_t readPayload(uint32_t block, uint16_t offset, uint8_t *buf,
+                          size_t len, uint16_t used) {
+  if (offset >= used)
+    return 0;
+  if (len > (size_t)(used - offset))
+    len = used - offset;
+  if (block == ring.total()) {
+    memcpy(buf, openBlock.payload + offset, len);
+    return len;
+  }
+  if (block < oldestBlock() ||
+      !ring.read(block - oldestBlock(), buf,
+                 (uint16_t)(sizeof(BlockHeader) + offset), (uint16_t)len))
+    return 0;
+  return len;
+}
+
+// ── Writing ────────────────────────────────────────────────────────────────
+
+static void closeBlock() {
+  openBlock.hdr.block = ring.total();
+  if (!ring.append(&openBlock)) {
+    Serial.println("[Archive] Block write FAILED!");
+  } else {
+    Serial.printf("[Archive] Block %lu: %u readings, %s B/reading\n",
+                  (unsigned long)(ring.total() - 1), openBlock.hdr.count,
+                  String((float)ARCHIVE_BLOCK_SIZE / openBlock.hdr.count, 2).c_str());
+  }
+  openBlock.hdr.count = 0;
+}
+
+void ArchiveMgr::addReading(uint32_t epoch, float distanceCm) {
+  BlockHeader &h = openBlock.hdr;
+  int32_t deci = lroundf(distanceCm * 10.0f);
+
+  if (h.count > 0) {
+    if (epoch < h.lastEpoch)
+      return; // clock stepped backwards; keep the archive sorted
+
+    int32_t delta = (int32_t)(epoch - h.lastEpoch);
+    uint8_t enc[10];
+    uint8_t n = putVarint(enc, zigzag(delta - prevDelta));
+    n += putVarint(enc + n, zigzag(deci - prevDeci));
+    if (h.used + n <= PAYLOAD_SIZE) {
+      memcpy(openBlock.payload + h.used, enc, n);
+      h.used += n;
+      h.count++;
+      h.lastEpoch = epoch;
+      prevDelta = delta;
+      prevDeci = deci;
+      nextSeq++;
+      return;
+    }
+    closeBlock();
+  }
+
+  // Start a new block with this reading stored in full
+  h.firstEpoch = h.lastEpoch = epoch;
+  h.firstSeq = nextSeq++;
+  h.firstDeci = deci;
+  h.count = 1;
+  h.used = 0;
+  prevDelta = 0;
+  prevDeci = deci;
+}
+
+void ArchiveMgr::begin() {
+  openBlock.hdr.count = 0;
+  nextSeq = 0;
+  // Blocks of the single-file layout have no block number; start over
+  if (LittleFS.exists(ARCHIVE_PATH)) {
+    Serial.println("[Archive] Discarding archive in the old block format");
+    LittleFS.remove(ARCHIVE_PATH);
+  }
+  if (!ring.begin())
+    return;
+
+  BlockHeader last;
+  uint32_t resumeFrom = 0;
+  if (ring.count() > 0 && ring.read(ring.count() - 1, &last, 0, sizeof(last))) {
+    nextSeq = last.firstSeq + last.count;
+    resumeFrom = last.lastEpoch + 1;
+  }
+
+  // The open block was lost with RAM; rebuild it from the raw ring
+  uint32_t replayed = 0;
+  StorageMgr::RangeReader tail(resumeFrom);
+  StorageMgr::Reading r;
+  while (tail.next(r)) {
+    addReading(r.epoch, r.distanceCm);
+    replayed++;
+  }
+
+  Stats s = getStats();
+  Serial.printf("[Archive] %lu readings in %u/%u blocks (%s B/reading), "
+                "%lu replayed\n",
+                (unsigned long)s.readings, (unsigned)s.blocks,
+                (unsigned)s.capacity, String(s.bytesPerReading, 2).c_str(),
+                (unsigned long)replayed);
+}
+
+uint32_t ArchiveMgr::oldestEpoch() {
+  BlockHeader h;
+  return readHeader(oldestBlock(), h) ? h.firstEpoch : 0;
+}
+
+ArchiveMgr::Stats ArchiveMgr::getStats() {
+  Stats s = {};
+  BlockHeader h;
+  s.blocks = ring.count();
+  s.capacity = ring.capacity();
+  if (readHeader(oldestBlock(), h)) {
+    s.readings = nextSeq - h.firstSeq;
+    s.oldestEpoch = h.firstEpoch;
+  }
+  s.bytes = s.blocks * ARCHIVE_BLOCK_SIZE;
+  if (openBlock.hdr.count > 0)
+    s.bytes += sizeof(BlockHeader) + openBlock.hdr.used;
+  if (s.readings > 0)
+    s.bytesPerReading = (float)s.bytes / s.readings;
+  return s;
+}
+
+// ── Reading ────────────────────────────────────────────────────────────────
+
+/// Position on the first reading of `block` (or the oldest block left).
+bool ArchiveMgr::Reader::load(uint32_t block) {
+  if (block < oldestBlock())
+    block = oldestBlock(); // overwritten while we were reading
+  BlockHeader h;
+  if (!readHeader(block, h))
+    return false;
+  _block = block;
+  _seq = h.firstSeq;
+  _epoch = h.firstEpoch;
+  _deci = h.firstDeci;
+  _delta = 0;
+  _offset = 0;
+  _used = h.used;
+  _left = h.count - 1;
+  return true;
+}
+
+/// Decode the reading after the current one, moving to the next block at
+/// the end of this one. False when there is nothing left.
+bool ArchiveMgr::Reader::advance() {
+  if (_left == 0)
+    return load(_block + 1);
+
+  uint8_t buf[10];
+  uint32_t dod, dv;
+  size_t len = readPayload(_block, _offset, buf, sizeof(buf), _used);
+  uint8_t a = getVarint(buf, len, dod);
+  uint8_t b = a ? getVarint(buf + a, len - a, dv) : 0;
+  if (b == 0) {
+    _left = 0; // block overwritten or damaged: continue with the next one
+    return load(_block + 1);
+  }
+
+  _delta += unzigzag(dod);
+  _epoch += _delta;
+  _deci += unzigzag(dv);
+  _offset += a + b;
+  _left--;
+  _seq++;
+  return true;
+}
+
+ArchiveMgr::Reader::Reader(uint32_t from, uint32_t to) {
+  if (to < from)
+    return;
+
+  // First block whose newest reading is at or after `from`
+  uint32_t lo = oldestBlock(), hi = blockLimit();
+  BlockHeader h;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (readHeader(mid, h) && h.lastEpoch < from)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo >= blockLimit() || !load(lo))
+    return;
+  _valid = true;
+  while (_epoch < from) {
+    if (!advance()) {
+      _valid = false;
+      return;
+    }
+  }
+
+  if (to == UINT32_MAX) {
+    _endSeq = nextSeq;
+    return;
+  }
+
+  // Last block starting at or before `to`, then count into it
+  lo = _block;
+  hi = blockLimit();
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (readHeader(mid, h) && h.firstEpoch <= to)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  Reader probe(*this);
+  if (lo > _block && !probe.load(lo - 1))
+    return;
+  _endSeq = probe._seq;
+  do {
+    if (probe._epoch > to)
+      break;
+    _endSeq = probe._seq + 1;
+  } while (probe.advance());
+}
+
+bool ArchiveMgr::Reader::next(uint32_t &epoch, float &distanceCm) {
+  if (remaining() == 0)
+    return false;
+  epoch = _epoch;
+  distanceCm = _deci / 10.0f;
+  if (!advance())
+    _valid = false;
+  return true;
+}
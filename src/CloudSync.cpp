@@ -1,129 +1,397 @@
 #include "CloudSync.h"
 #include "Config.h"
+#include "HttpExchange.h"
+#include "JsonWriter.h"
+#include "OutboxManager.h"
+#include "ScratchArena.h"
+#include "SettingsManager.h"
 #include <ArduinoJson.h>
-#include <ESP8266HTTPClient.h>
 #include <ESP8266WiFi.h>
-#include <Preferences.h>
-#include <WiFiClientSecure.h>
-
+#include <time.h>
 
 namespace CloudSync {
-static Preferences prefs;
 
-CloudConfig pushData(float distance, float warnThr, float alarmThr,
-                     const String &status) {
+// ─── Outbound request state machine ─────────────────────────────────────────
+// One request at a time on an HttpExchange; each loop() advances it a single
+// step and handles the response once it completes.
+enum class Kind : uint8_t { PUSH, MIGRATE };
 
-  CloudConfig config;
-  if (WiFi.status() != WL_CONNECTED)
-    return config;
+struct PushRequest {
+  float distance;
+  float warnThr;
+  float alarmThr;
+  const char *status; // one of the status literals, never freed
 
-  // Load metadata
-  prefs.begin("wifi", true); // read-only
-  String station = prefs.getString("station", "Antwerpen");
-  String river = prefs.getString("river", "Schelde");
-  prefs.end();
+  bool operator==(const PushRequest &o) const {
+    return distance == o.distance && warnThr == o.warnThr &&
+           alarmThr == o.alarmThr && strcmp(status, o.status) == 0;
+  }
+};
 
-  WiFiClientSecure client;
-  client.setInsecure();
+static HttpExchange http;
+static Kind activeKind = Kind::PUSH;
+static ConfigCallback configCallback = nullptr;
+static WakeCallback wakeCallback = nullptr;
 
-  HTTPClient http;
+static bool pushQueued = false;
+static PushRequest queuedPush = {0, 0, 0, "NORMAL"};
+static PushRequest activePush = {0, 0, 0, "NORMAL"};
 
-  Serial.printf("[Cloud] Pushing status for station: %s\n", station.c_str());
-  // Send API key as query parameter for authentication
-  String fullUrl = String(CLOUD_NETLIFY_URL) + "?key=" + String(CLOUD_API_KEY);
-
-  if (http.begin(client, fullUrl)) {
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("Authorization", CLOUD_API_KEY);
-
-    // Build JSON payload — ESP sends only sensor data, cloud fetches weather
-    // independently
-    JsonDocument doc;
-    doc["distance"] = distance;
-    doc["warning"] = warnThr;
-    doc["alarm"] = alarmThr;
-    doc["status"] = status;
-    doc["station"] = station;
-    doc["river"] = river;
-
-    String payload;
-    serializeJson(doc, payload);
-
-    int httpCode = http.POST(payload);
-
-    if (httpCode > 0) {
-      Serial.printf("[Cloud] POST result: %d\n", httpCode);
-      String response = http.getString();
-
-      if (httpCode == 200) {
-        JsonDocument respDoc;
-        deserializeJson(respDoc, response);
-
-        config.success = true;
-
-        if (respDoc["nextInterval"].is<int32_t>()) {
-          config.nextIntervalS = respDoc["nextInterval"];
-          Serial.printf("[Cloud] Received Interval: %d s\n",
-                        config.nextIntervalS);
-        }
-
-        // Parse updated thresholds if returned inside "data"
-        if (respDoc["data"]["warning"].is<float>()) {
-          config.warningThreshold = respDoc["data"]["warning"];
-          Serial.printf("[Cloud] Leader warning definition: %s cm\n",
-                        String(config.warningThreshold, 1).c_str());
-        }
-        if (respDoc["data"]["alarm"].is<float>()) {
-          config.alarmThreshold = respDoc["data"]["alarm"];
-          Serial.printf("[Cloud] Leader alarm definition: %s cm\n",
-                        String(config.alarmThreshold, 1).c_str());
-        }
-
-      } else {
-        Serial.println("[Cloud] Response: " + response);
-      }
-      http.end();
-      return config;
+// Readings waiting for the next batched push (distance in 1/10 cm)
+typedef OutboxMgr::Entry BatchSample;
+static BatchSample batch[CLOUD_BATCH_SIZE];
+static uint16_t batchLen = 0;
+static unsigned long batchStartMs = 0;
+static const char *lastStatus = "";
+static bool haveSnapshot = false; // queuedPush holds a real status
+
+// Readings carried by the push in flight. Live readings go to the outbox if
+// the push fails; readings taken from the outbox are popped on success.
+static const uint16_t SENDING_MAX = CLOUD_BATCH_SIZE > OUTBOX_REPLAY_BATCH
+                                        ? CLOUD_BATCH_SIZE
+                                        : OUTBOX_REPLAY_BATCH;
+static BatchSample sending[SENDING_MAX];
+static uint16_t sendingLen = 0;
+static bool sendingFromOutbox = false;
+static unsigned long lastReplayMs = 0;
+
+static bool migrationQueued = false;
+static String migOld, migNew, migRiver;
+
+// Body of the request in flight; HttpExchange sends it without a copy
+static char payload[CLOUD_PAYLOAD_MAX];
+
+static String host;
+static String pushPath;
+
+/// Split CLOUD_NETLIFY_URL into host and path once.
+static void parseEndpoint() {
+  if (host.length() > 0)
+    return;
+  String url = CLOUD_NETLIFY_URL;
+  int start = url.indexOf("://");
+  start = start < 0 ? 0 : start + 3;
+  int slash = url.indexOf('/', start);
+  host = url.substring(start, slash);
+  pushPath = url.substring(slash);
+}
+
+/// A push was not delivered: keep its live readings for replay.
+static void spillSending() {
+  if (activeKind == Kind::PUSH && !sendingFromOutbox && sendingLen > 0)
+    OutboxMgr::push(sending, sendingLen);
+  sendingLen = 0;
+}
+
+/// The push with `sending` didn't fit in `payload`: send the oldest half
+/// instead, repeatedly, and leave the rest queued in the outbox. A single
+/// reading that still doesn't fit is dropped rather than retried forever.
+/// Returns the payload length, 0 if even the bare status doesn't fit.
+static size_t shrinkSending() {
+  if (!sendingFromOutbox) {
+    // The outbox was empty, so queueing the live readings keeps the order
+    OutboxMgr::push(sending, sendingLen);
+    sendingFromOutbox = true;
+  }
+  size_t len = 0;
+  while (len == 0 && sendingLen > 0) {
+    if (sendingLen == 1) {
+      OutboxMgr::discard(1);
+      sendingLen = 0;
     } else {
-      Serial.printf("[Cloud] POST failed: %s\n",
-                    http.errorToString(httpCode).c_str());
+      sendingLen /= 2;
     }
-    http.end();
+    len = buildPushPayload(payload, sizeof(payload), activePush.distance,
+                           activePush.warnThr, activePush.alarmThr,
+                           activePush.status, sending, sendingLen);
   }
-  return config;
+  Serial.printf("[Cloud] Batch cut to %u readings to fit\n", sendingLen);
+  return len;
 }
 
-bool migrateStation(const String &oldName, const String &newName,
-                    const String &river) {
+size_t buildPushPayload(char *buf, size_t size, float distance, float warnThr,
+                        float alarmThr, const char *status,
+                        const OutboxMgr::Entry *samples, uint16_t count) {
+  // ESP sends only sensor data, cloud fetches weather independently.
+  // Levels go out in 0.1 cm, the resolution of the batch samples.
+  JsonWriter w(buf, size);
+  w.beginObject();
+  w.key("distance").value(distance, 1);
+  w.key("warning").value(warnThr, 1);
+  w.key("alarm").value(alarmThr, 1);
+  w.key("status").value(status);
+  w.key("station").value(SettingsMgr::station().c_str());
+  w.key("river").value(SettingsMgr::river().c_str());
+
+  if (count > 0) {
+    // {"t0":epoch,"v0":tenths,"scale":10,"dt":[...],"dv":[...]}
+    // Each later sample is stored as the difference to its predecessor,
+    // which keeps a steady series down to a few bytes per reading.
+    w.key("batch").beginObject();
+    w.key("t0").value(samples[0].epoch);
+    w.key("v0").value(samples[0].tenths);
+    w.key("scale").value(10);
+    w.key("dt").beginArray();
+    for (uint16_t i = 1; i < count; i++)
+      w.value((int32_t)(samples[i].epoch - samples[i - 1].epoch));
+    w.endArray();
+    w.key("dv").beginArray();
+    for (uint16_t i = 1; i < count; i++)
+      w.value(samples[i].tenths - samples[i - 1].tenths);
+    w.endArray();
+    w.endObject();
+  }
+  w.endObject();
 
+  if (w.overflowed()) {
+    Serial.printf("[Cloud] Payload needs %u bytes, buffer has %u\n",
+                  (unsigned)w.length() + 1, (unsigned)size);
+    return 0;
+  }
+  return w.length();
+}
+
+/// Record a reading for the next batched push. When the buffer is full
+/// (link down or a push still in flight) it is moved to the outbox.
+static void addToBatch(float distance) {
+  if (distance <= 0)
+    return; // the cloud ignores invalid readings in history anyway
+  if (batchLen == CLOUD_BATCH_SIZE) {
+    OutboxMgr::push(batch, batchLen);
+    batchLen = 0;
+  }
+  if (batchLen == 0)
+    batchStartMs = millis();
+  batch[batchLen].epoch = (uint32_t)time(nullptr);
+  batch[batchLen].tenths = (int32_t)lroundf(distance * 10.0f);
+  batchLen++;
+}
+
+static bool batchDue() {
+  return batchLen >= CLOUD_BATCH_SIZE ||
+         (batchLen > 0 && millis() - batchStartMs >= CLOUD_BATCH_MAX_AGE_MS);
+}
+
+static size_t buildMigrationPayload() {
+  JsonWriter w(payload, sizeof(payload));
+  w.beginObject();
+  w.key("oldStation").value(migOld.c_str());
+  w.key("newStation").value(migNew.c_str());
+  w.key("river").value(migRiver.c_str());
+  w.endObject();
+  return w.overflowed() ? 0 : w.length();
+}
+
+/// Pick the next queued request (migration first, it is rare and one-shot).
+static void dispatchNext() {
+  if (!pushQueued && batchDue())
+    pushQueued = true;
+  // Replay-only pushes are paced so a long backlog drains at a bounded rate
+  bool replayDue = haveSnapshot && OutboxMgr::depth() > 0 &&
+                   millis() - lastReplayMs >= OUTBOX_REPLAY_INTERVAL_MS;
+  if (!migrationQueued && !pushQueued && !replayDue)
+    return;
   if (WiFi.status() != WL_CONNECTED)
-    return false;
+    return; // keep it queued; readings overflow into the outbox
 
-  WiFiClientSecure client;
-  client.setInsecure();
-  HTTPClient http;
+  parseEndpoint();
+  String path = pushPath;
+  size_t len;
 
-  // Construct migration URL (based on the push URL but different endpoint)
-  String url = CLOUD_NETLIFY_URL;
-  url.replace("push-status", "migrate-station");
-  url += "?key=";
-  url += CLOUD_API_KEY;
+  if (migrationQueued) {
+    migrationQueued = false;
+    activeKind = Kind::MIGRATE;
+    // Construct migration URL (based on the push URL but different endpoint)
+    path.replace("push-status", "migrate-station");
+    len = buildMigrationPayload();
+  } else {
+    pushQueued = false;
+    activeKind = Kind::PUSH;
+    activePush = queuedPush;
+
+    if (OutboxMgr::depth() > 0) {
+      // Oldest first: the live batch joins the back of the queue
+      if (batchLen > 0) {
+        OutboxMgr::push(batch, batchLen);
+        batchLen = 0;
+      }
+      sendingLen = OutboxMgr::peek(sending, OUTBOX_REPLAY_BATCH);
+      sendingFromOutbox = true;
+      lastReplayMs = millis();
+    } else {
+      memcpy(sending, batch, sizeof(BatchSample) * batchLen);
+      sendingLen = batchLen;
+      batchLen = 0;
+      sendingFromOutbox = false;
+    }
+    Serial.printf("[Cloud] Pushing status for station: %s\n",
+                  SettingsMgr::station().c_str());
+    if (sendingLen > 0)
+      Serial.printf("[Cloud] Sending batch of %u readings\n", sendingLen);
+    len = buildPushPayload(payload, sizeof(payload), activePush.distance,
+                           activePush.warnThr, activePush.alarmThr,
+                           activePush.status, sending, sendingLen);
+    if (len == 0 && sendingLen > 0)
+      len = shrinkSending();
+  }
+  if (len == 0) {
+    spillSending();
+    return;
+  }
+
+  // Send API key as query parameter for authentication
+  path += "?key=" CLOUD_API_KEY;
+  http.begin(host, 443, true, "POST", path,
+             "Content-Type: application/json\r\n"
+             "Authorization: " CLOUD_API_KEY "\r\n",
+             payload, len, CLOUD_RESPONSE_TIMEOUT_MS);
+}
+
+static void handlePushResponse(int httpCode, const char *body) {
+  CloudConfig config;
+  Serial.printf("[Cloud] POST result: %d\n", httpCode);
+
+  if (httpCode != 200) {
+    Serial.printf("[Cloud] Response: %s\n", body);
+    spillSending();
+    return;
+  }
+
+  if (sendingFromOutbox)
+    OutboxMgr::pop(sendingLen);
+  sendingLen = 0;
+
+  JsonDocument respDoc(&ScratchArena::shared());
+  deserializeJson(respDoc, body);
+
+  config.success = true;
+
+  if (respDoc["nextInterval"].is<int32_t>()) {
+    config.nextIntervalS = respDoc["nextInterval"];
+    Serial.printf("[Cloud] Received Interval: %d s\n", config.nextIntervalS);
+  }
+
+  // Parse updated thresholds if returned inside "data"
+  if (respDoc["data"]["warning"].is<float>()) {
+    config.warningThreshold = respDoc["data"]["warning"];
+    Serial.printf("[Cloud] Leader warning definition: %s cm\n",
+                  String(config.warningThreshold, 1).c_str());
+  }
+  if (respDoc["data"]["alarm"].is<float>()) {
+    config.alarmThreshold = respDoc["data"]["alarm"];
+    Serial.printf("[Cloud] Leader alarm definition: %s cm\n",
+                  String(config.alarmThreshold, 1).c_str());
+  }
+
+  if (configCallback)
+    configCallback(config);
+}
+
+/// Hand a completed exchange to its response handler.
+static void finishRequest() {
+  if (http.state() == HttpExchange::State::FAILED) {
+    Serial.printf("[Cloud] %s failed: %s\n",
+                  activeKind == Kind::PUSH ? "POST" : "Migration", http.error());
+    spillSending();
+  } else if (activeKind == Kind::PUSH) {
+    handlePushResponse(http.status(), http.body().c_str());
+  } else {
+    int httpCode = http.status();
+    bool ok = (httpCode == 200 || httpCode == 204);
+    Serial.printf("[Cloud] Migration %s (%d)\n", ok ? "successful" : "failed",
+                  httpCode);
+  }
+  http.reset();
+}
 
-  if (http.begin(client, url)) {
-    http.addHeader("Content-Type", "application/json");
+// ─── Public API ────────────────────────────────────────────────────────────
 
-    JsonDocument doc;
-    doc["oldStation"] = oldName;
-    doc["newStation"] = newName;
-    doc["river"] = river;
+void onConfig(ConfigCallback callback) { configCallback = callback; }
 
-    String payload;
-    serializeJson(doc, payload);
+void onWake(WakeCallback callback) { wakeCallback = callback; }
 
-    int httpCode = http.POST(payload);
-    http.end();
-    return (httpCode == 200 || httpCode == 204);
+void requestPush(float distance, float warnThr, float alarmThr,
+                 const char *status, bool flushNow) {
+  PushRequest req{distance, warnThr, alarmThr, status};
+  bool transition = strcmp(status, lastStatus) != 0;
+  lastStatus = status;
+  haveSnapshot = true;
+  queuedPush = req; // latest status rides along with the batch
+  addToBatch(distance); // every reading is kept, coalesced or not
+
+  if (!transition && http.busy() && activeKind == Kind::PUSH &&
+      activePush == req) {
+    Serial.println("[Cloud] Push coalesced with request in flight.");
+    return;
+  }
+  if (pushQueued) {
+    Serial.println("[Cloud] Push coalesced with queued request.");
+  }
+
+  // Batching must never delay an alarm: status changes and ALARM readings
+  // go out right away.
+  if (flushNow || transition || strcmp(status, "ALARM") == 0 || batchDue())
+    pushQueued = true;
+  if (wakeCallback)
+    wakeCallback(); // to send now, or to time the batch
+}
+
+void requestMigration(const String &oldName, const String &newName,
+                      const String &river) {
+  migOld = oldName;
+  migNew = newName;
+  migRiver = river;
+  migrationQueued = true;
+  if (wakeCallback)
+    wakeCallback();
+}
+
+void loop() {
+  if (!http.busy()) {
+    dispatchNext();
+    return;
+  }
+  if (http.step())
+    finishRequest();
+}
+
+void stash() {
+  if (batchLen == 0)
+    return;
+  OutboxMgr::push(batch, batchLen);
+  batchLen = 0;
+}
+
+bool isBusy() {
+  return http.busy() || pushQueued || migrationQueued;
+}
+
+/// Time left until `startMs + periodMs`, or 0 if that has passed.
+static int32_t remaining(unsigned long startMs, uint32_t periodMs) {
+  unsigned long elapsed = millis() - startMs;
+  return elapsed >= periodMs ? 0 : (int32_t)(periodMs - elapsed);
+}
+
+int32_t nextStepMs() {
+  if (http.busy())
+    return 0;
+  int32_t wait = -1;
+  if (pushQueued || migrationQueued)
+    wait = 0;
+  if (batchLen > 0) {
+    int32_t w = remaining(batchStartMs, CLOUD_BATCH_MAX_AGE_MS);
+    if (wait < 0 || w < wait)
+      wait = w;
+  }
+  if (haveSnapshot && OutboxMgr::depth() > 0) {
+    int32_t w = remaining(lastReplayMs, OUTBOX_REPLAY_INTERVAL_MS);
+    if (wait < 0 || w < wait)
+      wait = w;
   }
-  return false;
+  // Offline, dispatchNext() only keeps things queued: check back slowly
+  if (wait >= 0 && WiFi.status() != WL_CONNECTED &&
+      wait < (int32_t)SCHED_LINK_CHECK_MS)
+    wait = SCHED_LINK_CHECK_MS;
+  return wait;
 }
 } // namespace CloudSync
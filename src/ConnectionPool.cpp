@@ -0,0 +1,183 @@
+#include "ConnectionPool.h"
+#include "Config.h"
+#include <WiFiClientSecure.h>
+
+namespace ConnPool {
+
+struct Slot {
+  char host[48];
+  uint16_t port;
+  bool secure;
+  bool inUse;
+  bool hasSession;
+  int8_t mfln; // server takes POOL_TLS_BUFFER_BYTES fragments: -1 not probed
+  unsigned long lastUsed;
+  WiFiClient plain;
+  BearSSL::WiFiClientSecure tls;
+  BearSSL::Session session;
+
+  WiFiClient &client() { return secure ? (WiFiClient &)tls : plain; }
+  bool isOpen() { return host[0] != '\0' && client().connected(); }
+};
+
+static Slot slots[POOL_MAX_HOSTS];
+static Stats stats = {};
+
+static void closeSlot(Slot &s) {
+  s.client().stop(); // frees the BearSSL buffers, keeps `session`
+}
+
+/// Close every idle open socket while the heap is short.
+static void shedIdle() {
+  if (ESP.getFreeHeap() >= POOL_LOW_HEAP_BYTES)
+    return;
+  for (Slot &s : slots) {
+    if (!s.inUse && s.isOpen()) {
+      closeSlot(s);
+      stats.evictions++;
+    }
+  }
+}
+
+static int liveTlsContexts() {
+  int n = 0;
+  for (Slot &s : slots) {
+    if (s.secure && (s.inUse || s.isOpen()))
+      n++;
+  }
+  return n;
+}
+
+/// Least-recently-used idle slot matching the filter, or nullptr.
+static Slot *lruIdle(bool secureOnly, bool openOnly) {
+  Slot *victim = nullptr;
+  for (Slot &s : slots) {
+    if (s.inUse || (secureOnly && !s.secure) || (openOnly && !s.isOpen()))
+      continue;
+    if (!victim || s.lastUsed < victim->lastUsed)
+      victim = &s;
+  }
+  return victim;
+}
+
+static Slot *findSlot(const char *host, uint16_t port, bool secure) {
+  for (Slot &s : slots) {
+    if (s.port == port && s.secure == secure && strcmp(s.host, host) == 0)
+      return &s;
+  }
+
+  // Claim an empty slot, or recycle the least-recently-used idle one
+  Slot *slot = nullptr;
+  for (Slot &s : slots) {
+    if (s.host[0] == '\0') {
+      slot = &s;
+      break;
+    }
+  }
+  if (!slot) {
+    slot = lruIdle(false, false);
+    if (!slot)
+      return nullptr;
+    if (slot->isOpen())
+      stats.evictions++;
+    closeSlot(*slot);
+    slot->session = BearSSL::Session(); // never offer it to the new host
+    slot->hasSession = false;
+  }
+
+  strncpy(slot->host, host, sizeof(slot->host) - 1);
+  slot->host[sizeof(slot->host) - 1] = '\0';
+  slot->port = port;
+  slot->secure = secure;
+  slot->mfln = -1;
+  slot->lastUsed = 0;
+  return slot;
+}
+
+WiFiClient *acquire(const char *host, uint16_t port, bool secure) {
+  Slot *slot = findSlot(host, port, secure);
+  if (!slot || slot->inUse) {
+    Serial.printf("[Pool] No free slot for %s\n", host);
+    return nullptr;
+  }
+
+  if (slot->isOpen()) {
+    stats.reuses++;
+    slot->inUse = true;
+    slot->lastUsed = millis();
+    return &slot->client();
+  }
+
+  shedIdle();
+  if (secure && liveTlsContexts() >= POOL_MAX_TLS_CONTEXTS) {
+    Slot *victim = lruIdle(true, true);
+    if (!victim) {
+      Serial.printf("[Pool] TLS context cap reached, deferring %s\n", host);
+      return nullptr;
+    }
+    closeSlot(*victim);
+    stats.evictions++;
+  }
+
+  WiFiClient &client = slot->client();
+  client.setTimeout(POOL_CONNECT_TIMEOUT_MS);
+  if (secure) {
+    // A server that accepts small fragments lets BearSSL run in ~1 KB of
+    // buffers instead of ~17 KB. Probed once per host (one extra connect).
+    if (slot->mfln < 0)
+      slot->mfln = slot->tls.probeMaxFragmentLength(host, port,
+                                                    POOL_TLS_BUFFER_BYTES);
+    if (slot->mfln) {
+      slot->tls.setBufferSizes(POOL_TLS_BUFFER_BYTES, POOL_TLS_BUFFER_BYTES);
+      stats.smallBuffers++;
+    } else {
+      // Incoming records may be 16 KB; what we send can stay small
+      slot->tls.setBufferSizes(16384, POOL_TLS_BUFFER_BYTES);
+    }
+    slot->tls.setInsecure(); // No fingerprint management, as before
+    slot->tls.setSession(&slot->session);
+    stats.handshakes++;
+    if (slot->hasSession)
+      stats.resumeAttempts++;
+  }
+
+  stats.connects++;
+  if (!client.connect(host, port)) {
+    stats.failures++;
+    Serial.printf("[Pool] Connect to %s:%u failed\n", host, port);
+    client.stop();
+    return nullptr;
+  }
+  if (secure)
+    slot->hasSession = true;
+
+  slot->inUse = true;
+  slot->lastUsed = millis();
+  return &client;
+}
+
+void release(WiFiClient *client, bool keepAlive) {
+  for (Slot &s : slots) {
+    if (&s.client() != client)
+      continue;
+    s.inUse = false;
+    s.lastUsed = millis();
+    if (!keepAlive)
+      closeSlot(s);
+    return;
+  }
+}
+
+void loop() {
+  shedIdle();
+  unsigned long now = millis();
+  for (Slot &s : slots) {
+    if (!s.inUse && now - s.lastUsed >= POOL_IDLE_TIMEOUT_MS && s.isOpen()) {
+      closeSlot(s);
+    }
+  }
+}
+
+const Stats &getStats() { return stats; }
+
+} // namespace ConnPool
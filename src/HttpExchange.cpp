@@ -0,0 +1,256 @@
+#include "HttpExchange.h"
+#include "ConnectionPool.h"
+
+static const size_t READ_CHUNK = 256;    // bytes drained per step()
+static const size_t MAX_RESPONSE = 4096; // response bytes kept for parsing
+
+void HttpExchange::begin(const String &host, uint16_t port, bool secure,
+                         const char *method, const String &path,
+                         const String &headers, const char *body,
+                         size_t bodyLen, unsigned long timeoutMs) {
+  reset();
+  _host = host;
+  _port = port;
+  _secure = secure;
+  _timeoutMs = timeoutMs;
+
+  _head.reserve(128 + path.length() + headers.length());
+  _head += method;
+  _head += ' ';
+  _head += path;
+  _head += " HTTP/1.1\r\nHost: ";
+  _head += host;
+  _head += "\r\n";
+  _head += headers;
+  _head += "Connection: keep-alive\r\nContent-Length: ";
+  _head += String(bodyLen);
+  _head += "\r\n\r\n";
+  _payload = body;
+  _payloadLen = bodyLen;
+
+  _response.reserve(1024);
+  enter(State::CONNECTING);
+}
+
+void HttpExchange::reset() {
+  releaseClient(false);
+  _head = String();
+  _payload = nullptr;
+  _payloadLen = 0;
+  _response = String();
+  _body = String();
+  _status = 0;
+  _error = "";
+  _headerEnd = -1;
+  _contentLength = -1;
+  _chunked = false;
+  _serverCloses = false;
+  _state = State::IDLE;
+}
+
+void HttpExchange::enter(State next) {
+  _state = next;
+  _stateSince = millis();
+}
+
+void HttpExchange::releaseClient(bool keepAlive) {
+  if (_client)
+    ConnPool::release(_client, keepAlive);
+  _client = nullptr;
+}
+
+void HttpExchange::fail(const char *reason) {
+  releaseClient(false);
+  _head = String();
+  _payload = nullptr;
+  _payloadLen = 0;
+  _response = String();
+  _error = reason;
+  enter(State::FAILED);
+}
+
+bool HttpExchange::step() {
+  switch (_state) {
+  case State::CONNECTING:
+    // Reuses the pooled keep-alive socket when open; otherwise this is the
+    // one step that blocks, for a (resumed when possible) TLS handshake.
+    _client = ConnPool::acquire(_host.c_str(), _port, _secure);
+    if (_client) {
+      enter(State::SENDING);
+    } else {
+      fail("connect");
+    }
+    break;
+
+  case State::SENDING:
+    sendRequest();
+    break;
+
+  case State::RECEIVING:
+    receive();
+    break;
+
+  default:
+    return false;
+  }
+  return _state == State::DONE || _state == State::FAILED;
+}
+
+void HttpExchange::sendRequest() {
+  if (_client->write((const uint8_t *)_head.c_str(), _head.length()) !=
+          _head.length() ||
+      _client->write((const uint8_t *)_payload, _payloadLen) != _payloadLen) {
+    fail("write");
+    return;
+  }
+  _head = String();
+  _payload = nullptr;
+  _payloadLen = 0;
+  enter(State::RECEIVING);
+}
+
+/// Case-insensitive header lookup within the header block.
+static String headerValue(const String &headers, const char *name) {
+  String lower = headers;
+  lower.toLowerCase();
+  String key = String("\r\n") + name + ":";
+  int at = lower.indexOf(key);
+  if (at < 0)
+    return String();
+  int start = at + key.length();
+  int end = headers.indexOf("\r\n", start);
+  String value = headers.substring(start, end < 0 ? headers.length() : end);
+  value.trim();
+  value.toLowerCase();
+  return value;
+}
+
+void HttpExchange::parseHeaders() {
+  _headerEnd = _response.indexOf("\r\n\r\n");
+  if (_headerEnd < 0)
+    return;
+  String headers = _response.substring(0, _headerEnd + 2);
+  String len = headerValue(headers, "content-length");
+  _contentLength = len.length() > 0 ? len.toInt() : -1;
+  _chunked = headerValue(headers, "transfer-encoding").indexOf("chunked") >= 0;
+  _serverCloses = headerValue(headers, "connection") == "close" ||
+                  _response.startsWith("HTTP/1.0");
+}
+
+/// Offset of the CRLF at or after `from` in `p[0..len)`, or -1.
+static long findCrlf(const char *p, size_t len, size_t from) {
+  for (size_t i = from; i + 1 < len; i++) {
+    if (p[i] == '\r' && p[i + 1] == '\n')
+      return i;
+  }
+  return -1;
+}
+
+/// Walk a chunked body: `size[;ext]CRLF data CRLF ... 0CRLF [trailers] CRLF`.
+/// Appends the chunk data to `out` when given. Returns the bytes the body
+/// took up once the terminating empty line has arrived, 0 while more is
+/// needed, or -1 if the framing is broken.
+static long parseChunked(const char *p, size_t len, String *out) {
+  size_t at = 0;
+  for (;;) {
+    long eol = findCrlf(p, len, at);
+    if (eol < 0)
+      return 0;
+    size_t size = 0;
+    size_t i = at;
+    for (; i < (size_t)eol && isxdigit((unsigned char)p[i]); i++) {
+      size = size * 16 + (isdigit((unsigned char)p[i]) ? p[i] - '0'
+                                                       : (p[i] | 0x20) - 'a' + 10);
+      if (size > MAX_RESPONSE)
+        return -1;
+    }
+    if (i == at || (i < (size_t)eol && p[i] != ';' && p[i] != ' ' && p[i] != '\t'))
+      return -1;
+    at = eol + 2;
+
+    if (size == 0) {
+      // Trailer fields up to the empty line
+      for (;;) {
+        eol = findCrlf(p, len, at);
+        if (eol < 0)
+          return 0;
+        if ((size_t)eol == at)
+          return eol + 2;
+        at = eol + 2;
+      }
+    }
+
+    if (len < at + size + 2)
+      return 0;
+    if (p[at + size] != '\r' || p[at + size + 1] != '\n')
+      return -1;
+    if (out)
+      out->concat(p + at, size);
+    at += size + 2;
+  }
+}
+
+/// True once the full body has arrived on a length-delimited response.
+bool HttpExchange::bodyComplete() const {
+  if (_headerEnd < 0)
+    return false;
+  size_t bodyStart = _headerEnd + 4;
+  size_t bodyLen = _response.length() - bodyStart;
+  if (_contentLength >= 0)
+    return bodyLen >= (size_t)_contentLength;
+  if (_chunked) // a broken frame also ends the wait; finishResponse fails it
+    return parseChunked(_response.c_str() + bodyStart, bodyLen, nullptr) != 0;
+  return false; // delimited by close
+}
+
+void HttpExchange::finishResponse(bool keepAlive) {
+  const char *raw = _headerEnd < 0 ? "" : _response.c_str() + _headerEnd + 4;
+  _body = String();
+  // A chunked body cut short by the peer keeps the chunks that did arrive,
+  // as a short Content-Length body does; broken framing fails
+  long framed = _chunked ? parseChunked(raw, strlen(raw), &_body) : 0;
+  releaseClient(keepAlive && !_serverCloses && framed >= 0);
+
+  // "HTTP/1.1 200 OK\r\n...\r\n\r\n<body>"
+  int httpCode = 0;
+  int sp = _response.indexOf(' ');
+  if (_response.startsWith("HTTP/") && sp > 0)
+    httpCode = atoi(_response.c_str() + sp + 1);
+  if (httpCode <= 0 || framed < 0) {
+    fail("malformed response");
+    return;
+  }
+
+  if (!_chunked)
+    _body = String(raw);
+  _status = httpCode;
+  _response = String();
+  enter(State::DONE);
+}
+
+void HttpExchange::receive() {
+  int avail = _client->available();
+  if (avail > 0) {
+    uint8_t buf[READ_CHUNK];
+    int n = _client->read(buf, avail < (int)READ_CHUNK ? avail : READ_CHUNK);
+    if (n > 0 && _response.length() + n > MAX_RESPONSE) {
+      // Nothing we call returns this much: give the socket (and the TLS
+      // context) back now instead of draining until the timeout
+      fail("response too large");
+      return;
+    }
+    if (n > 0)
+      _response.concat((const char *)buf, n);
+    if (_headerEnd < 0)
+      parseHeaders();
+    if (bodyComplete())
+      finishResponse(true);
+    return;
+  }
+
+  if (!_client->connected()) {
+    finishResponse(false);
+  } else if (millis() - _stateSince >= _timeoutMs) {
+    fail("timeout");
+  }
+}
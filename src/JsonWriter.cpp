@@ -0,0 +1,120 @@
+#include "JsonWriter.h"
+
+void JsonWriter::put(const char *s, size_t n) {
+  if (_len < _size) {
+    size_t room = _size - 1 - _len;
+    size_t copy = n < room ? n : room;
+    memcpy(_buf + _len, s, copy);
+    _buf[_len + copy] = '\0';
+  }
+  _len += n;
+}
+
+void JsonWriter::putUnsigned(unsigned long long v) {
+  char digits[20];
+  uint8_t n = sizeof(digits);
+  do {
+    digits[--n] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  put(digits + n, sizeof(digits) - n);
+}
+
+void JsonWriter::putSigned(long long v) {
+  if (v < 0) {
+    put('-');
+    putUnsigned(0ULL - (unsigned long long)v);
+  } else {
+    putUnsigned(v);
+  }
+}
+
+JsonWriter &JsonWriter::value(const char *s) {
+  separator();
+  if (!s) {
+    put("null", 4);
+    return *this;
+  }
+  put('"');
+  const char *run = s; // start of bytes that need no escaping
+  for (; *s; s++) {
+    uint8_t c = *s;
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    put(run, s - run);
+    run = s + 1;
+    char esc[7] = {'\\', 0};
+    switch (c) {
+    case '"':
+    case '\\':
+      esc[1] = c;
+      break;
+    case '\n':
+      esc[1] = 'n';
+      break;
+    case '\r':
+      esc[1] = 'r';
+      break;
+    case '\t':
+      esc[1] = 't';
+      break;
+    default:
+      snprintf(esc + 1, sizeof(esc) - 1, "u%04x", c);
+      break;
+    }
+    put(esc, strlen(esc));
+  }
+  put(run, s - run);
+  put('"');
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(bool b) {
+  separator();
+  if (b)
+    put("true", 4);
+  else
+    put("false", 5);
+  return *this;
+}
+
+JsonWriter &JsonWriter::fixed(long scaled, uint8_t decimals) {
+  separator();
+  if (decimals > 9)
+    decimals = 9;
+  unsigned long mag = scaled < 0 ? 0UL - (unsigned long)scaled : scaled;
+  unsigned long div = 1;
+  for (uint8_t i = 0; i < decimals; i++)
+    div *= 10;
+  unsigned long frac = mag % div;
+  if (scaled < 0)
+    put('-');
+  putUnsigned(mag / div);
+  if (frac == 0)
+    return *this;
+
+  while (frac % 10 == 0) {
+    frac /= 10;
+    decimals--;
+  }
+  char digits[10];
+  for (uint8_t i = decimals; i > 0; i--) {
+    digits[i] = '0' + frac % 10;
+    frac /= 10;
+  }
+  digits[0] = '.';
+  put(digits, decimals + 1);
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(float v, uint8_t decimals) {
+  if (isnan(v) || isinf(v)) {
+    separator();
+    put("null", 4);
+    return *this;
+  }
+  float scale = 1;
+  for (uint8_t i = 0; i < decimals; i++)
+    scale *= 10;
+  return fixed(lroundf(v * scale), decimals);
+}
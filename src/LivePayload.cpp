@@ -0,0 +1,79 @@
+#include "LivePayload.h"
+#include "JsonWriter.h"
+#include "SettingsManager.h"
+
+uint32_t LivePayload::fnv1a(const char *s, size_t len, uint32_t hash) {
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (uint8_t)s[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+void LivePayload::setText(Snapshot &snap, const char *forecast) {
+  snap.forecast = forecast;
+  snap.station = SettingsMgr::station().c_str();
+  snap.river = SettingsMgr::river().c_str();
+  snap.forecastHash = fnv1a(snap.forecast, strlen(snap.forecast));
+  snap.stationHash = fnv1a(snap.station, strlen(snap.station));
+  snap.riverHash = fnv1a(snap.river, strlen(snap.river));
+}
+
+size_t LivePayload::writeStatus(char *buf, size_t size, const Snapshot &s,
+                                int entries, int confidence) {
+  JsonWriter w(buf, size);
+  w.beginObject();
+  w.key("distance").fixed(s.distance10, 1);
+  w.key("warning").fixed(s.warning10, 1);
+  w.key("alarm").fixed(s.alarm10, 1);
+  w.key("rainExpected").value(s.rainExpected);
+  w.key("forecast").value(s.forecast);
+  w.key("entries").value(entries);
+  w.key("station").value(s.station);
+  w.key("river").value(s.river);
+  w.key("interval").value(s.interval);
+  w.key("confidence").value(confidence);
+  w.key("status").value(s.status);
+  w.endObject();
+  return w.length();
+}
+
+size_t LivePayload::writeFrame(char *buf, size_t size, const Snapshot &cur,
+                               const Snapshot *prev) {
+  JsonWriter w(buf, size);
+  w.beginObject();
+  w.key("type").value(prev ? "delta" : "full");
+  if (!prev || cur.distance10 != prev->distance10)
+    w.key("distance").fixed(cur.distance10, 1);
+  if (!prev || cur.warning10 != prev->warning10)
+    w.key("warning").fixed(cur.warning10, 1);
+  if (!prev || cur.alarm10 != prev->alarm10)
+    w.key("alarm").fixed(cur.alarm10, 1);
+  if (!prev || cur.rainExpected != prev->rainExpected)
+    w.key("rainExpected").value(cur.rainExpected);
+  if (!prev || cur.forecastHash != prev->forecastHash)
+    w.key("forecast").value(cur.forecast);
+  if (!prev || cur.stationHash != prev->stationHash)
+    w.key("station").value(cur.station);
+  if (!prev || cur.riverHash != prev->riverHash)
+    w.key("river").value(cur.river);
+  if (!prev || cur.interval != prev->interval)
+    w.key("interval").value(cur.interval);
+  if (!prev || strcmp(cur.status, prev->status) != 0)
+    w.key("status").value(cur.status);
+  w.endObject();
+  return w.length();
+}
+
+size_t LivePayload::writeHistoryAppend(char *buf, size_t size,
+                                       const StorageMgr::Reading &r,
+                                       uint32_t seq) {
+  JsonWriter w(buf, size);
+  w.beginObject();
+  w.key("type").value("history");
+  w.key("seq").value(seq);
+  w.key("ts").value(r.epoch);
+  w.key("val").value(r.distanceCm, 1);
+  w.endObject();
+  return w.length();
+}
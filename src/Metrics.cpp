@@ -0,0 +1,288 @@
+#include "Metrics.h"
+#include "ArchiveManager.h"
+#include "Config.h"
+#include "PowerManager.h"
+#include "SamplingManager.h"
+#include "Scheduler.h"
+#include "ScratchArena.h"
+
+namespace Metrics {
+
+static StageStats stages[STAGE_COUNT];
+static StageStats latencies[LATENCY_COUNT];
+
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "sensor",    "sensor_poll", "reading", "websocket", "log",
+    "weather",   "manual_sync", "migration", "cloud",   "notify",
+    "pool",      "settings",    "loop"};
+
+static const char *const LATENCY_NAMES[LATENCY_COUNT] = {"buzzer", "websocket"};
+
+// Bucket i holds durations <= 64 µs * 4^i; the last one everything above
+static const uint8_t BOUNDED_BUCKETS = BUCKET_COUNT - 1;
+
+static uint32_t heapFree = 0;
+static uint32_t heapFreeMin = UINT32_MAX;
+static uint32_t heapMaxBlock = 0;
+static uint32_t heapMaxBlockMin = UINT32_MAX;
+static uint8_t heapFragmentation = 0;
+static unsigned long lastHeapSample = 0;
+static bool heapSampled = false;
+
+// Per-uptime-day minima, newest at dayIndex, so a slow leak or creeping
+// fragmentation shows up as a trend rather than one all-time low
+struct HeapDay {
+  uint32_t freeMin;
+  uint32_t maxBlockMin;
+};
+static const unsigned long DAY_MS = 86400000UL;
+static HeapDay heapDays[METRICS_HEAP_DAYS];
+static uint8_t dayIndex = 0;
+static uint8_t daysKept = 0;
+static unsigned long dayStart = 0;
+
+uint32_t bucketBoundUs(uint8_t i) {
+  return i < BOUNDED_BUCKETS ? 64UL << (2 * i) : 0;
+}
+
+static void addSample(StageStats &s, uint32_t durationUs) {
+  s.count++;
+  s.lastUs = durationUs;
+  if (durationUs > s.maxUs)
+    s.maxUs = durationUs;
+  s.totalUs += durationUs;
+
+  uint8_t b = 0;
+  while (b < BOUNDED_BUCKETS && durationUs > bucketBoundUs(b))
+    b++;
+  s.buckets[b]++;
+}
+
+void record(Stage stage, uint32_t durationUs) {
+  addSample(stages[stage], durationUs);
+}
+
+void recordLatency(Latency which, uint32_t latencyUs) {
+  addSample(latencies[which], latencyUs);
+}
+
+void sampleHeap() {
+  unsigned long now = millis();
+  if (heapSampled && now - lastHeapSample < METRICS_HEAP_SAMPLE_MS)
+    return;
+  lastHeapSample = now;
+  heapSampled = true;
+
+  heapFree = ESP.getFreeHeap();
+  heapMaxBlock = ESP.getMaxFreeBlockSize();
+  heapFragmentation = ESP.getHeapFragmentation();
+  if (heapFree < heapFreeMin)
+    heapFreeMin = heapFree;
+  if (heapMaxBlock < heapMaxBlockMin)
+    heapMaxBlockMin = heapMaxBlock;
+
+  if (daysKept == 0 || now - dayStart >= DAY_MS) {
+    if (daysKept > 0) {
+      dayIndex = (dayIndex + 1) % METRICS_HEAP_DAYS;
+      dayStart += DAY_MS;
+    } else {
+      dayStart = now;
+    }
+    if (daysKept < METRICS_HEAP_DAYS)
+      daysKept++;
+    heapDays[dayIndex] = {UINT32_MAX, UINT32_MAX};
+  }
+  HeapDay &d = heapDays[dayIndex];
+  if (heapFree < d.freeMin)
+    d.freeMin = heapFree;
+  if (heapMaxBlock < d.maxBlockMin)
+    d.maxBlockMin = heapMaxBlock;
+}
+
+const StageStats &getStage(Stage stage) { return stages[stage]; }
+
+const StageStats &getLatency(Latency which) { return latencies[which]; }
+
+const char *stageName(Stage stage) {
+  return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+// ─── Prometheus text format ─────────────────────────────────────────────────
+// Durations are exported in seconds as fixed-point text, which avoids
+// float formatting in printf.
+
+static void printSeconds(Print &out, uint64_t us) {
+  out.printf("%lu.%06lu", (unsigned long)(us / 1000000ULL),
+             (unsigned long)(us % 1000000ULL));
+}
+
+static void printHeader(Print &out, const char *name, const char *type,
+                        const char *help) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void printGauge(Print &out, const char *name, const char *help,
+                       uint32_t value) {
+  printHeader(out, name, "gauge", help);
+  out.printf("%s %lu\n", name, (unsigned long)value);
+}
+
+/// One labelled series of a histogram family: _bucket lines, _sum, _count.
+static void printHistogram(Print &out, const char *family, const char *label,
+                           const char *value, const StageStats &s) {
+  uint32_t cumulative = 0;
+  for (uint8_t b = 0; b < BOUNDED_BUCKETS; b++) {
+    cumulative += s.buckets[b];
+    out.printf("%s_bucket{%s=\"%s\",le=\"", family, label, value);
+    printSeconds(out, bucketBoundUs(b));
+    out.printf("\"} %lu\n", (unsigned long)cumulative);
+  }
+  out.printf("%s_bucket{%s=\"%s\",le=\"+Inf\"} %lu\n", family, label, value,
+             (unsigned long)s.count);
+  out.printf("%s_sum{%s=\"%s\"} ", family, label, value);
+  printSeconds(out, s.totalUs);
+  out.printf("\n%s_count{%s=\"%s\"} %lu\n", family, label, value,
+             (unsigned long)s.count);
+}
+
+void writePrometheus(Print &out) {
+  printHeader(out, "flood_stage_duration_seconds", "histogram",
+              "Time spent per loop() stage.");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    printHistogram(out, "flood_stage_duration_seconds", "stage",
+                   STAGE_NAMES[i], stages[i]);
+    yield();
+  }
+
+  printHeader(out, "flood_alarm_latency_seconds", "histogram",
+              "Time from a completed sensor sample to the local alarm output.");
+  for (uint8_t i = 0; i < LATENCY_COUNT; i++) {
+    printHistogram(out, "flood_alarm_latency_seconds", "path",
+                   LATENCY_NAMES[i], latencies[i]);
+  }
+  printHeader(out, "flood_alarm_latency_max_seconds", "gauge",
+              "Worst sample-to-output latency since boot.");
+  for (uint8_t i = 0; i < LATENCY_COUNT; i++) {
+    out.printf("flood_alarm_latency_max_seconds{path=\"%s\"} ",
+               LATENCY_NAMES[i]);
+    printSeconds(out, latencies[i].maxUs);
+    out.print("\n");
+  }
+
+  printHeader(out, "flood_stage_last_seconds", "gauge",
+              "Duration of the most recent run of each stage.");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    out.printf("flood_stage_last_seconds{stage=\"%s\"} ", STAGE_NAMES[i]);
+    printSeconds(out, stages[i].lastUs);
+    out.print("\n");
+  }
+
+  printHeader(out, "flood_stage_max_seconds", "gauge",
+              "Longest run of each stage since boot.");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    out.printf("flood_stage_max_seconds{stage=\"%s\"} ", STAGE_NAMES[i]);
+    printSeconds(out, stages[i].maxUs);
+    out.print("\n");
+  }
+
+  printHeader(out, "flood_task_runs_total", "counter",
+              "Scheduler task executions.");
+  for (uint8_t i = 0; i < Scheduler::taskCount(); i++) {
+    const Scheduler::TaskInfo &t = Scheduler::getTask(i);
+    out.printf("flood_task_runs_total{task=\"%s\"} %lu\n", t.name,
+               (unsigned long)t.runs);
+  }
+  printHeader(out, "flood_task_deadline_misses_total", "counter",
+              "Runs that started later than the task's deadline.");
+  for (uint8_t i = 0; i < Scheduler::taskCount(); i++) {
+    const Scheduler::TaskInfo &t = Scheduler::getTask(i);
+    out.printf("flood_task_deadline_misses_total{task=\"%s\"} %lu\n", t.name,
+               (unsigned long)t.missedDeadlines);
+  }
+  printHeader(out, "flood_task_max_lateness_seconds", "gauge",
+              "Worst start delay past the due time.");
+  for (uint8_t i = 0; i < Scheduler::taskCount(); i++) {
+    const Scheduler::TaskInfo &t = Scheduler::getTask(i);
+    out.printf("flood_task_max_lateness_seconds{task=\"%s\"} ", t.name);
+    printSeconds(out, (uint64_t)t.maxLatenessMs * 1000ULL);
+    out.print("\n");
+  }
+  printHeader(out, "flood_scheduler_idle_seconds_total", "counter",
+              "Time the scheduler spent sleeping between tasks.");
+  out.print("flood_scheduler_idle_seconds_total ");
+  printSeconds(out, (uint64_t)Scheduler::idleMs() * 1000ULL);
+  out.print("\n");
+
+  printGauge(out, "flood_heap_free_bytes", "Free heap at the last sample.",
+             heapFree);
+  printGauge(out, "flood_heap_free_min_bytes", "Lowest free heap seen.",
+             heapSampled ? heapFreeMin : 0);
+  printGauge(out, "flood_heap_max_block_bytes",
+             "Largest allocatable block at the last sample.", heapMaxBlock);
+  printGauge(out, "flood_heap_max_block_min_bytes",
+             "Smallest largest-block seen.", heapSampled ? heapMaxBlockMin : 0);
+  printGauge(out, "flood_heap_fragmentation_percent",
+             "Heap fragmentation at the last sample.", heapFragmentation);
+  printHeader(out, "flood_heap_daily_min_bytes", "gauge",
+              "Lowest free heap and largest block per uptime day (0 = today).");
+  for (uint8_t i = 0; i < daysKept; i++) {
+    const HeapDay &d =
+        heapDays[(dayIndex + METRICS_HEAP_DAYS - i) % METRICS_HEAP_DAYS];
+    out.printf("flood_heap_daily_min_bytes{kind=\"free\",days_ago=\"%u\"} %lu\n",
+               i, (unsigned long)d.freeMin);
+    out.printf("flood_heap_daily_min_bytes{kind=\"max_block\",days_ago=\"%u\"} "
+               "%lu\n", i, (unsigned long)d.maxBlockMin);
+  }
+
+  ScratchArena &arena = ScratchArena::shared();
+  printGauge(out, "flood_scratch_high_water_bytes",
+             "Most of the JSON scratch arena in use at once.", arena.highWater());
+  printGauge(out, "flood_scratch_capacity_bytes",
+             "Size of the JSON scratch arena.", arena.capacity());
+  printHeader(out, "flood_scratch_heap_fallbacks_total", "counter",
+              "Scratch allocations that did not fit and used the heap.");
+  out.printf("flood_scratch_heap_fallbacks_total %lu\n",
+             (unsigned long)arena.heapFallbacks());
+  printGauge(out, "flood_sample_interval_seconds",
+             "Current adaptive sensor sample interval.",
+             SamplingMgr::intervalMs() / 1000);
+
+  const PowerMgr::Stats &p = PowerMgr::getStats();
+  printGauge(out, "flood_power_samples", "Readings taken, incl. deep-sleep wakes.",
+             p.samples);
+  printGauge(out, "flood_power_radio_on_seconds", "Time awake with WiFi up.",
+             p.radioOnMs / 1000);
+  printGauge(out, "flood_power_radio_off_seconds",
+             "Time awake with the radio off.", p.radioOffMs / 1000);
+  printGauge(out, "flood_power_sleep_seconds", "Time in deep sleep.", p.sleepS);
+  printGauge(out, "flood_power_radio_wakes",
+             "Times WiFi came up to upload or alert.", p.radioWakes);
+  printGauge(out, "flood_power_energy_per_sample_microjoules",
+             "Estimated energy per reading (on-times x POWER_*_MA).",
+             (uint32_t)(PowerMgr::energyPerSampleMJ() * 1000.0f));
+  printGauge(out, "flood_power_average_current_microamps",
+             "Estimated average supply current.",
+             (uint32_t)(PowerMgr::averageCurrentMA() * 1000.0f));
+  printHeader(out, "flood_power_wake_to_sample_seconds", "gauge",
+              "Deep-sleep timer wake to completed reading.");
+  out.print("flood_power_wake_to_sample_seconds{stat=\"last\"} ");
+  printSeconds(out, p.lastWakeToSampleUs);
+  out.print("\nflood_power_wake_to_sample_seconds{stat=\"max\"} ");
+  printSeconds(out, p.maxWakeToSampleUs);
+  out.print("\n");
+
+  ArchiveMgr::Stats a = ArchiveMgr::getStats();
+  printGauge(out, "flood_archive_readings", "Readings in the compressed archive.",
+             a.readings);
+  printGauge(out, "flood_archive_bytes", "Flash used by the archive.", a.bytes);
+  printGauge(out, "flood_archive_capacity_bytes",
+             "Flash reserved for the archive.",
+             a.capacity * ARCHIVE_BLOCK_SIZE);
+  printGauge(out, "flood_archive_oldest_timestamp_seconds",
+             "Epoch of the oldest archived reading.", a.oldestEpoch);
+
+  printGauge(out, "flood_uptime_seconds", "Seconds since boot.",
+             millis() / 1000);
+}
+
+} // namespace Metrics
@@ -1,44 +1,226 @@
 #include "NotificationManager.h"
 #include "Config.h"
-#include <WiFiClientSecure.h>
-#include <ESP8266HTTPClient.h>
+#include "HttpExchange.h"
+#include "JsonWriter.h"
+#include "ScratchArena.h"
+#include "TextBuffer.h"
+#include <ArduinoJson.h>
+#include <ESP8266WiFi.h>
 
-bool NotificationMgr::sendTelegram(const String& message) {
-    if (!NOTIFICATIONS_ENABLED) return false;
+// ─── Send queue ──────────────────────────────────────────────────────────────
+// FIFO of pending messages; the head is the one being sent or waiting for its
+// retry time. Nothing here ever blocks the caller. Texts live in the slots
+// themselves, so queueing a message never allocates.
+struct Message {
+    char text[NOTIFY_TEXT_MAX];
+    uint8_t attempts;
+    unsigned long readyAt; // millis() before which the head must not be sent
+};
+
+static const unsigned long COOLDOWN_MS = TELEGRAM_COOLDOWN_MIN * 60000UL;
+
+static Message queue[NOTIFY_QUEUE_SIZE];
+static uint8_t head = 0;
+static uint8_t count = 0;
+static HttpExchange http;
+static NotificationMgr::Stats stats = {};
+
+// Request body of the send in flight. Room for the text with every
+// character escaped once ("\n", "\""), which covers anything but raw
+// control characters.
+static char body[2 * NOTIFY_TEXT_MAX + 48];
+
+// Alarm coalescing: one message opens a cooldown window, later alarms in the
+// window are only counted and summarised when it closes.
+static bool alarmWindow = false;
+static unsigned long windowStart = 0;
+static uint32_t suppressed = 0;
+static float closestCm = 0;
+static float latestCm = 0;
+
+static NotificationMgr::WakeCallback wakeCallback = nullptr;
 
-    String token = TELEGRAM_BOT_TOKEN;
-    String chatID = TELEGRAM_CHAT_ID;
+static void wake() {
+    if (wakeCallback) wakeCallback();
+}
+
+static void pop() {
+    queue[head].text[0] = '\0';
+    head = (head + 1) % NOTIFY_QUEUE_SIZE;
+    count--;
+}
 
-    if (token == "YOUR_BOT_TOKEN_HERE" || chatID == "YOUR_CHAT_ID_HERE") {
+static bool credentialsSet() {
+    return strcmp(TELEGRAM_BOT_TOKEN, "YOUR_BOT_TOKEN_HERE") != 0 &&
+           strcmp(TELEGRAM_CHAT_ID, "YOUR_CHAT_ID_HERE") != 0;
+}
+
+bool NotificationMgr::queueTelegram(const char* message) {
+    if (!NOTIFICATIONS_ENABLED) return false;
+    if (!credentialsSet()) {
         Serial.println("[Notify] ERROR: Telegram credentials not set in Config.h");
         return false;
     }
+    if (count == NOTIFY_QUEUE_SIZE) {
+        stats.overflow++;
+        Serial.println("[Notify] Queue full, message dropped.");
+        return false;
+    }
+    Message& m = queue[(head + count) % NOTIFY_QUEUE_SIZE];
+    strncpy(m.text, message, sizeof(m.text) - 1);
+    m.text[sizeof(m.text) - 1] = '\0';
+    if (strlen(message) >= sizeof(m.text)) {
+        // Cut before a split UTF-8 sequence; Telegram rejects invalid text
+        size_t end = sizeof(m.text) - 1;
+        while (end > 0 && ((uint8_t)message[end] & 0xC0) == 0x80) end--;
+        m.text[end] = '\0';
+    }
+    m.attempts = 0;
+    m.readyAt = millis();
+    count++;
+    wake();
+    return true;
+}
 
-    WiFiClientSecure client;
-    client.setInsecure(); // No fingerprint management needed for simple alerts
-
-    HTTPClient http;
-    
-    // URL format: https://api.telegram.org/bot<TOKEN>/sendMessage?chat_id=<CHAT_ID>&text=<MSG>
-    String url = "https://api.telegram.org/bot" + token + "/sendMessage";
-    url += "?chat_id=" + chatID;
-    url += "&text=" + message;
-
-    Serial.println("[Notify] Sending Telegram alert...");
-    
-    if (http.begin(client, url)) {
-        int httpCode = http.GET();
-        if (httpCode > 0) {
-            Serial.printf("[Notify] Telegram response: %d\n", httpCode);
-            http.end();
-            return (httpCode == 200);
-        } else {
-            Serial.printf("[Notify] Telegram GET failed: %s\n", http.errorToString(httpCode).c_str());
+void NotificationMgr::onWake(WakeCallback callback) { wakeCallback = callback; }
+
+void NotificationMgr::reportAlarm(float distanceCm) {
+    if (alarmWindow && millis() - windowStart < COOLDOWN_MS) {
+        if (suppressed == 0 || distanceCm < closestCm) closestCm = distanceCm;
+        latestCm = distanceCm;
+        suppressed++;
+        stats.coalesced++;
+        return;
+    }
+    TextBuffer<NOTIFY_TEXT_MAX> text;
+    text.printf("🚨 FLOOD ALARM! Water: %.1f cm", distanceCm);
+    queueTelegram(text.c_str());
+    alarmWindow = true;
+    windowStart = millis();
+    suppressed = 0;
+    wake(); // the window's end is due a summary check
+}
+
+/// Close an expired cooldown window. If alarms kept coming in, summarise
+/// them and start the next window, so a long flood sends one message per
+/// cooldown period instead of one per reading.
+static void checkAlarmWindow() {
+    if (!alarmWindow || millis() - windowStart < COOLDOWN_MS) return;
+    if (suppressed == 0) {
+        alarmWindow = false;
+        return;
+    }
+    TextBuffer<NOTIFY_TEXT_MAX> text;
+    text.printf("🚨 FLOOD ALARM continues: %lu more alarm readings in %u min. "
+                "Closest water: %.1f cm, latest: %.1f cm",
+                (unsigned long)suppressed, (unsigned)TELEGRAM_COOLDOWN_MIN, closestCm,
+                latestCm);
+    NotificationMgr::queueTelegram(text.c_str());
+    windowStart = millis();
+    suppressed = 0;
+}
+
+/// False if the message can't be encoded into `body`.
+static bool startSend(const Message& m) {
+    JsonWriter w(body, sizeof(body));
+    w.beginObject();
+    w.key("chat_id").value(TELEGRAM_CHAT_ID);
+    w.key("text").value(m.text);
+    w.endObject();
+    if (w.overflowed()) return false;
+
+    Serial.printf("[Notify] Sending Telegram message (attempt %u)...\n", m.attempts + 1);
+    http.begin("api.telegram.org", 443, true, "POST",
+               "/bot" TELEGRAM_BOT_TOKEN "/sendMessage",
+               "Content-Type: application/json\r\n", body, w.length(),
+               NOTIFY_RESPONSE_TIMEOUT_MS);
+    return true;
+}
+
+/// Delay before the next attempt: NOTIFY_RETRY_BASE_MS doubled per failure,
+/// or the wait Telegram asked for on a 429.
+static unsigned long retryDelay(uint8_t attempts) {
+    if (http.state() == HttpExchange::State::DONE && http.status() == 429) {
+        JsonDocument doc(&ScratchArena::shared());
+        if (!deserializeJson(doc, http.body()) &&
+            doc["parameters"]["retry_after"].is<uint32_t>()) {
+            return doc["parameters"]["retry_after"].as<uint32_t>() * 1000UL;
         }
-        http.end();
+    }
+    unsigned long wait = NOTIFY_RETRY_BASE_MS;
+    for (uint8_t i = 1; i < attempts && wait < NOTIFY_RETRY_MAX_MS; i++) wait *= 2;
+    return wait < NOTIFY_RETRY_MAX_MS ? wait : NOTIFY_RETRY_MAX_MS;
+}
+
+static void finishSend() {
+    Message& m = queue[head];
+    bool done = http.state() == HttpExchange::State::DONE;
+    int code = http.status();
+
+    if (done && code == 200) {
+        Serial.println("[Notify] Telegram message sent.");
+        stats.sent++;
+        pop();
+    } else if (done && code >= 400 && code < 500 && code != 429) {
+        // Bad token, unknown chat, malformed text: retrying won't help
+        Serial.printf("[Notify] Telegram rejected message (%d): %s\n", code,
+                      http.body().c_str());
+        stats.dropped++;
+        pop();
+    } else if (++m.attempts >= NOTIFY_MAX_ATTEMPTS) {
+        Serial.printf("[Notify] Giving up after %u attempts.\n", m.attempts);
+        stats.dropped++;
+        pop();
     } else {
-        Serial.println("[Notify] HTTP begin failed.");
+        unsigned long wait = retryDelay(m.attempts);
+        if (done) {
+            Serial.printf("[Notify] Telegram response %d, retry in %lu s\n", code, wait / 1000);
+        } else {
+            Serial.printf("[Notify] Send failed (%s), retry in %lu s\n", http.error(), wait / 1000);
+        }
+        m.readyAt = millis() + wait;
+        stats.retries++;
+    }
+    http.reset();
+}
+
+void NotificationMgr::loop() {
+    checkAlarmWindow();
+
+    if (http.busy()) {
+        if (http.step()) finishSend();
+        return;
     }
+    if (count == 0 || (long)(millis() - queue[head].readyAt) < 0) return;
+    if (WiFi.status() != WL_CONNECTED) return; // keep it queued, no attempt used
 
-    return false;
+    if (!startSend(queue[head])) {
+        Serial.println("[Notify] Message too long once escaped, dropped.");
+        stats.dropped++;
+        pop();
+    }
 }
+
+bool NotificationMgr::hasPending() { return count > 0; }
+
+int32_t NotificationMgr::nextStepMs() {
+    if (http.busy()) return 0;
+    unsigned long now = millis();
+    int32_t wait = -1;
+    if (count > 0) {
+        long until = (long)(queue[head].readyAt - now);
+        wait = until > 0 ? until : 0;
+        if (WiFi.status() != WL_CONNECTED && wait < (int32_t)SCHED_LINK_CHECK_MS)
+            wait = SCHED_LINK_CHECK_MS;
+    }
+    if (alarmWindow) {
+        long until = (long)(windowStart + COOLDOWN_MS - now);
+        if (until < 0) until = 0;
+        if (wait < 0 || until < wait) wait = until;
+    }
+    return wait;
+}
+
+uint8_t NotificationMgr::depth() { return count; }
+
+const NotificationMgr::Stats& NotificationMgr::getStats() { return stats; }
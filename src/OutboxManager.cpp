@@ -0,0 +1,74 @@
+#include "OutboxManager.h"
+#include "Config.h"
+#include "RingFile.h"
+#include <time.h>
+
+static RingFile ring(OUTBOX_PATH, sizeof(OutboxMgr::Entry), OUTBOX_CAPACITY);
+static uint32_t droppedCount = 0;
+static uint32_t replayedCount = 0;
+static uint8_t acksSinceCheckpoint = 0;
+
+void OutboxMgr::begin() {
+  if (!ring.begin())
+    return;
+  if (ring.count() > 0) {
+    Serial.printf("[Outbox] %u readings waiting for replay\n",
+                  (unsigned)ring.count());
+  }
+}
+
+void OutboxMgr::push(const Entry *entries, uint16_t count) {
+  uint32_t room = ring.capacity() - ring.count();
+  if (count > room) {
+    droppedCount += count - room;
+    if (!OUTBOX_DROP_OLDEST)
+      count = room; // keep the backlog, lose the newest
+  }
+  // One write and one sync for the whole batch
+  if (!ring.appendMany(entries, count))
+    Serial.println("[Outbox] Write FAILED!");
+  Serial.printf("[Outbox] Queued %u readings (depth %u)\n", count,
+                (unsigned)ring.count());
+}
+
+uint16_t OutboxMgr::peek(Entry *out, uint16_t max) {
+  uint16_t n = 0;
+  while (n < max && ring.read(n, &out[n]))
+    n++;
+  return n;
+}
+
+void OutboxMgr::pop(uint16_t count) {
+  // Losing the tail to a reset only means resending a few acked batches
+  ring.dropOldest(count, false);
+  replayedCount += count;
+  if (++acksSinceCheckpoint >= OUTBOX_CHECKPOINT_ACKS || ring.count() == 0)
+    checkpoint();
+}
+
+void OutboxMgr::discard(uint16_t count) {
+  if (count > ring.count())
+    count = ring.count();
+  ring.dropOldest(count);
+  droppedCount += count;
+  Serial.printf("[Outbox] Discarded %u readings\n", count);
+}
+
+void OutboxMgr::checkpoint() {
+  if (ring.syncTail())
+    acksSinceCheckpoint = 0;
+}
+
+int OutboxMgr::depth() { return (int)ring.count(); }
+
+uint32_t OutboxMgr::lagSeconds() {
+  Entry oldest;
+  if (!ring.read(0, &oldest))
+    return 0;
+  uint32_t now = (uint32_t)time(nullptr);
+  return now > oldest.epoch ? now - oldest.epoch : 0;
+}
+
+uint32_t OutboxMgr::dropped() { return droppedCount; }
+
+uint32_t OutboxMgr::replayed() { return replayedCount; }
@@ -0,0 +1,345 @@
+#include "PowerManager.h"
+#include "CloudSync.h"
+#include "Config.h"
+#include "NotificationManager.h"
+#include "OutboxManager.h"
+#include "SamplingManager.h"
+#include "SensorManager.h"
+#include "SettingsManager.h"
+#include "WeatherService.h"
+#include <ESP8266WiFi.h>
+#include <time.h>
+
+namespace PowerMgr {
+
+// ─── RTC memory ─────────────────────────────────────────────────────────────
+// Survives deep sleep (not power loss). Holds the readings taken on timer
+// wakes, the thresholds to judge them by and the energy counters.
+static const uint32_t RTC_MAGIC = 0x464C5057; // "FLPW"
+static const uint16_t RTC_SLOTS = 48;
+
+static const uint8_t RTC_RADIO_WAKE = 0x01; // next boot brings WiFi up
+static const uint8_t RTC_ALARM_WAKE = 0x02; // ...because of an ALARM reading
+static const uint8_t RTC_RAIN = 0x04;       // rain was forecast at last sync
+static const uint8_t RTC_LEVEL_WAKE = 0x08; // ...because of a reading past WARNING
+
+struct RtcState {
+  uint32_t magic;
+  uint32_t crc; // over everything after this field
+  uint32_t epoch;    // wall time when the last sleep began (estimated)
+  uint32_t sleepMs;  // planned length of that sleep
+  float warnCm;      // active thresholds at the last full wake
+  float alarmCm;
+  Stats stats;
+  uint16_t count;
+  uint8_t flags;
+  uint8_t reserved;
+  OutboxMgr::Entry readings[RTC_SLOTS];
+};
+
+static_assert(sizeof(RtcState) <= 512, "RTC user memory is 512 bytes");
+static_assert(LOW_POWER_FLUSH_READINGS <= RTC_SLOTS,
+              "LOW_POWER_FLUSH_READINGS exceeds the RTC buffer");
+
+static RtcState rtc;
+static Stats stats = {};
+
+static bool timerWake = false;
+static bool alarmBoot = false;     // woke for an ALARM reading, until NORMAL
+static bool thresholdBoot = false; // woke for a reading past WARNING
+static void (*radioUpCallback)() = nullptr;
+
+// ─── Radio state (full firmware) ────────────────────────────────────────────
+static bool radioOn = true;
+static bool linkAnnounced = false; // radioUpCallback ran for this window
+static unsigned long radioUpMs = 0;
+static unsigned long lastAccountMs = 0;
+static unsigned long awakeUntilMs = 0; // no power saving before this
+static bool urgent = false;
+static uint32_t samplesSinceUpload = 0;
+static unsigned long firstPendingMs = 0;
+
+static uint32_t crc32(const uint8_t *data, size_t len) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static uint32_t rtcChecksum() {
+  const uint8_t *body = (const uint8_t *)&rtc + offsetof(RtcState, epoch);
+  return crc32(body, sizeof(RtcState) - offsetof(RtcState, epoch));
+}
+
+static bool loadRtc() {
+  if (!ESP.rtcUserMemoryRead(0, (uint32_t *)&rtc, sizeof(rtc)))
+    return false;
+  return rtc.magic == RTC_MAGIC && rtc.crc == rtcChecksum() &&
+         rtc.count <= RTC_SLOTS;
+}
+
+static void saveRtc() {
+  rtc.magic = RTC_MAGIC;
+  rtc.stats = stats;
+  rtc.crc = rtcChecksum();
+  ESP.rtcUserMemoryWrite(0, (uint32_t *)&rtc, sizeof(rtc));
+}
+
+static void recordWakeLatency(uint32_t us) {
+  stats.lastWakeToSampleUs = us;
+  if (us > stats.maxWakeToSampleUs)
+    stats.maxWakeToSampleUs = us;
+}
+
+/// Estimated wall time. NTP is only available on radio boots.
+static uint32_t nowEpoch() {
+  time_t t = time(nullptr);
+  if (t > 100000)
+    return (uint32_t)t;
+  return rtc.epoch + (rtc.sleepMs + millis()) / 1000;
+}
+
+/// Book this boot's awake time, persist and sleep. Does not return.
+static void sleepFor(uint32_t ms, bool radioNext, bool radioThisBoot) {
+  SettingsMgr::flush(); // a pending debounced write would be lost
+  if (radioThisBoot)
+    stats.radioOnMs += millis() - lastAccountMs;
+  else
+    stats.radioOffMs += millis();
+  stats.sleepS += ms / 1000;
+  rtc.epoch = nowEpoch();
+  rtc.sleepMs = ms;
+  saveRtc();
+  Serial.printf("[Power] Deep sleep for %lu s%s\n", (unsigned long)(ms / 1000),
+                radioNext ? " (radio wake next)" : "");
+  Serial.flush();
+  ESP.deepSleep((uint64_t)ms * 1000ULL,
+                radioNext ? WAKE_RF_DEFAULT : WAKE_RF_DISABLED);
+}
+
+/// Timer wake with the radio off: one reading into RTC memory, then sleep.
+static void sampleAndSleep() {
+  stats.wakes++;
+  SensorMgr::begin();
+  float cm = SensorMgr::readDistanceCm();
+  recordWakeLatency(micros());
+  stats.samples++;
+  // A splash or the tank wall reads short on one ping; the radio only comes
+  // up for a level that a majority of fresh pings agree on
+  if (cm > 0 && cm <= rtc.warnCm) {
+    cm = SensorMgr::readMedianCm(3);
+    Serial.printf("[Power] Past WARNING on one ping, confirmed: %.1f cm\n", cm);
+  }
+
+  uint32_t epoch = nowEpoch();
+  if (cm > 0) {
+    if (rtc.count == RTC_SLOTS) { // only if uploads keep failing
+      memmove(rtc.readings, rtc.readings + 1,
+              sizeof(OutboxMgr::Entry) * (RTC_SLOTS - 1));
+      rtc.count--;
+    }
+    rtc.readings[rtc.count].epoch = epoch;
+    rtc.readings[rtc.count].tenths = (int32_t)lroundf(cm * 10.0f);
+    rtc.count++;
+  }
+
+  bool pastWarning = cm > 0 && cm <= rtc.warnCm;
+  bool due = rtc.count >= LOW_POWER_FLUSH_READINGS ||
+             (rtc.count > 0 &&
+              epoch - rtc.readings[0].epoch >= LOW_POWER_FLUSH_MAX_AGE_S);
+  if (pastWarning || due) {
+    // The radio can only be enabled by a reset: reboot straight into it
+    rtc.flags = RTC_RADIO_WAKE | (rtc.flags & RTC_RAIN);
+    if (pastWarning)
+      rtc.flags |= RTC_LEVEL_WAKE;
+    if (cm > 0 && cm <= rtc.alarmCm)
+      rtc.flags |= RTC_ALARM_WAKE;
+    Serial.printf("[Power] %s, waking the radio\n",
+                  pastWarning ? "Threshold crossed" : "Upload due");
+    sleepFor(1, true, false);
+  }
+
+  // Next interval from the buffered trend, continuing the last one
+  SamplingMgr::resume(rtc.sleepMs);
+  uint32_t interval = rtc.sleepMs;
+  for (uint16_t i = 0; i < rtc.count; i++) {
+    interval = SamplingMgr::update(rtc.readings[i].epoch * 1000UL,
+                                   rtc.readings[i].tenths / 10.0f, rtc.warnCm,
+                                   rtc.alarmCm, rtc.flags & RTC_RAIN);
+  }
+  sleepFor(interval, false, false);
+}
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+void begin() {
+  lastAccountMs = millis();
+  if (LOW_POWER_MODE == LOW_POWER_OFF)
+    return;
+
+  bool valid = LOW_POWER_MODE == LOW_POWER_DEEP_SLEEP && loadRtc();
+  timerWake = valid && ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE;
+  if (!valid)
+    memset(&rtc, 0, sizeof(rtc));
+  else
+    stats = rtc.stats;
+
+  if (!timerWake) {
+    // Power-on or reset: stay reachable for a while so it can be configured
+    awakeUntilMs = millis() + LOW_POWER_SETUP_WINDOW_MS;
+    Serial.printf("[Power] Low-power mode %d, awake for setup\n",
+                  LOW_POWER_MODE);
+    return;
+  }
+  if (rtc.flags & RTC_RADIO_WAKE) {
+    alarmBoot = rtc.flags & RTC_ALARM_WAKE;
+    thresholdBoot = rtc.flags & (RTC_LEVEL_WAKE | RTC_ALARM_WAKE);
+    urgent = thresholdBoot; // until the first live reading says otherwise
+    rtc.flags &= RTC_RAIN;
+    stats.radioWakes++;
+    Serial.printf("[Power] Radio wake, %u buffered readings\n", rtc.count);
+    return; // continue into the full firmware
+  }
+  sampleAndSleep();
+}
+
+bool wokeFromSleep() { return timerWake; }
+
+bool alarmWake() { return alarmBoot; }
+
+void flushRtcBuffer() {
+  if (rtc.count == 0)
+    return;
+  OutboxMgr::push(rtc.readings, rtc.count);
+  Serial.printf("[Power] %u readings from RTC memory queued for upload\n",
+                rtc.count);
+  rtc.count = 0;
+  if (LOW_POWER_MODE == LOW_POWER_DEEP_SLEEP)
+    saveRtc();
+}
+
+void onRadioUp(void (*callback)()) { radioUpCallback = callback; }
+
+bool retryLater() {
+  if (!timerWake)
+    return false;
+  if (thresholdBoot) {
+    // Never sleep through a crossed threshold: keep sampling and sounding
+    // the buzzer offline; loop() sleeps once the level is NORMAL again
+    Serial.println("[Power] No WiFi on a threshold wake, staying up offline");
+    return true;
+  }
+  Serial.println("[Power] No WiFi on radio wake, back to sleep");
+  sleepFor(SAMPLE_MAX_INTERVAL_MS, false, true);
+  return false;
+}
+
+static void radioUp() {
+  WiFi.forceSleepWake();
+  WiFi.mode(WIFI_STA);
+  WiFi.reconnect();
+  radioOn = true;
+  linkAnnounced = false;
+  radioUpMs = millis();
+  stats.radioWakes++;
+  Serial.printf("[Power] Radio on (%lu readings pending%s)\n",
+                (unsigned long)samplesSinceUpload, urgent ? ", level high" : "");
+}
+
+static void radioOff() {
+  WiFi.disconnect();
+  WiFi.forceSleepBegin();
+  radioOn = false;
+  samplesSinceUpload = 0;
+  Serial.printf("[Power] Radio off after %lu ms\n", millis() - radioUpMs);
+}
+
+void noteSample(bool isUrgent) {
+  stats.samples++;
+  urgent = isUrgent;
+  if (!urgent)
+    alarmBoot = thresholdBoot = false;
+  if (samplesSinceUpload++ == 0)
+    firstPendingMs = millis();
+  if (LOW_POWER_MODE == LOW_POWER_MODEM_SLEEP && urgent && !radioOn)
+    radioUp(); // don't wait for the next loop() to raise the alert
+}
+
+/// Everything queued has gone out (or the window timed out).
+static bool uploadsDone(unsigned long now) {
+  if (now - radioUpMs >= LOW_POWER_WIFI_TIMEOUT_MS)
+    return true;
+  return linkAnnounced && !CloudSync::isBusy() &&
+         !NotificationMgr::hasPending() && OutboxMgr::depth() == 0;
+}
+
+void loop() {
+  unsigned long now = millis();
+  if (radioOn)
+    stats.radioOnMs += now - lastAccountMs;
+  else
+    stats.radioOffMs += now - lastAccountMs;
+  lastAccountMs = now;
+
+  if (LOW_POWER_MODE == LOW_POWER_OFF)
+    return;
+
+  if (radioOn && !linkAnnounced && WiFi.status() == WL_CONNECTED) {
+    linkAnnounced = true;
+    if (radioUpCallback)
+      radioUpCallback();
+  }
+  if (urgent || (long)(now - awakeUntilMs) < 0)
+    return;
+
+  if (LOW_POWER_MODE == LOW_POWER_DEEP_SLEEP) {
+    if (samplesSinceUpload == 0 || !uploadsDone(now))
+      return;
+    // Unsent readings go to flash; thresholds go along for the timer wakes
+    CloudSync::stash();
+    OutboxMgr::checkpoint();
+    float factor = WeatherSvc::isRainExpected() ? RAIN_THRESHOLD_FACTOR : 1.0f;
+    rtc.warnCm = SettingsMgr::warningThreshold() * factor;
+    rtc.alarmCm = SettingsMgr::alarmThreshold() * factor;
+    rtc.flags = WeatherSvc::isRainExpected() ? RTC_RAIN : 0;
+    sleepFor(SamplingMgr::intervalMs(), false, true);
+    return;
+  }
+
+  // LOW_POWER_MODEM_SLEEP
+  if (radioOn) {
+    if (uploadsDone(now))
+      radioOff();
+  } else if (samplesSinceUpload >= LOW_POWER_FLUSH_READINGS ||
+             (samplesSinceUpload > 0 &&
+              now - firstPendingMs >= LOW_POWER_FLUSH_MAX_AGE_S * 1000UL) ||
+             NotificationMgr::hasPending()) {
+    radioUp();
+  }
+}
+
+const Stats &getStats() { return stats; }
+
+float energyPerSampleMJ() {
+  // mA x s x V = mJ
+  float mj = POWER_SUPPLY_V * (POWER_RADIO_ON_MA * stats.radioOnMs / 1000.0f +
+                               POWER_RADIO_OFF_MA * stats.radioOffMs / 1000.0f +
+                               POWER_DEEP_SLEEP_MA * stats.sleepS);
+  return stats.samples ? mj / stats.samples : 0.0f;
+}
+
+float averageCurrentMA() {
+  float seconds =
+      stats.radioOnMs / 1000.0f + stats.radioOffMs / 1000.0f + stats.sleepS;
+  if (seconds <= 0)
+    return 0.0f;
+  return (POWER_RADIO_ON_MA * stats.radioOnMs / 1000.0f +
+          POWER_RADIO_OFF_MA * stats.radioOffMs / 1000.0f +
+          POWER_DEEP_SLEEP_MA * stats.sleepS) /
+         seconds;
+}
+
+} // namespace PowerMgr
@@ -0,0 +1,314 @@
+#include "RingFile.h"
+
+static const uint32_t RING_MAGIC = 0x474E5246; // "FRNG"
+static const uint16_t RING_VERSION = 2;
+static const uint32_t TAIL_MAGIC = 0x4C544652; // "RFTL"
+
+RingFile::RingFile(const char *path, uint16_t recordSize, uint32_t capacity,
+                   uint16_t segmentBytes)
+    : _path(path), _recordSize(recordSize), _capacity(capacity) {
+  _perSegment = (segmentBytes - sizeof(SegmentHeader)) / recordSize;
+  if (_perSegment == 0)
+    _perSegment = 1;
+  if (_perSegment > capacity)
+    _perSegment = capacity;
+  // One spare segment, so recycling a segment only ever discards records
+  // that have already fallen out of the ring
+  _segments = (capacity + _perSegment - 1) / _perSegment + 1;
+}
+
+void RingFile::segmentPath(uint16_t seg, char *out) const {
+  snprintf(out, 32, "%s.%u", _path, (unsigned)seg);
+}
+
+bool RingFile::begin() {
+  _head.close();
+  _reader.close();
+  _headOpen = _readerOpen = _tailDirty = false;
+  _oldest = _total = 0;
+  if (!scan())
+    return false;
+  if (_total == 0 && LittleFS.exists(_path))
+    importLegacy();
+  return true;
+}
+
+/// Read segment `seg`'s header. `stored` is the number of whole records.
+bool RingFile::readSegment(uint16_t seg, uint32_t &firstSeq, uint32_t &stored) {
+  char name[32];
+  segmentPath(seg, name);
+  if (!LittleFS.exists(name))
+    return false;
+  File f = LittleFS.open(name, "r");
+  SegmentHeader h;
+  if (!f || f.read((uint8_t *)&h, sizeof(h)) != sizeof(h) ||
+      h.magic != RING_MAGIC || h.version != RING_VERSION ||
+      h.recordSize != _recordSize || h.firstSeq % _perSegment != 0 ||
+      segmentOf(h.firstSeq) != seg) {
+    Serial.printf("[Ring] Ignoring %s (different layout)\n", name);
+    return false;
+  }
+  uint32_t n = (f.size() - sizeof(h)) / _recordSize;
+  firstSeq = h.firstSeq;
+  stored = n < _perSegment ? n : _perSegment;
+  return true;
+}
+
+bool RingFile::scan() {
+  // The head is the segment that ends last
+  int32_t headSeg = -1;
+  uint32_t headFirst = 0, headStored = 0;
+  for (uint16_t s = 0; s < _segments; s++) {
+    uint32_t first, stored;
+    if (readSegment(s, first, stored) &&
+        (headSeg < 0 || first + stored > headFirst + headStored)) {
+      headSeg = s;
+      headFirst = first;
+      headStored = stored;
+    }
+    yield();
+  }
+
+  TailFile tail = {0, 0};
+  char tailName[32];
+  snprintf(tailName, sizeof(tailName), "%s.t", _path);
+  File t = LittleFS.open(tailName, "r");
+  if (t && (t.read((uint8_t *)&tail, sizeof(tail)) != sizeof(tail) ||
+            tail.magic != TAIL_MAGIC))
+    tail.seq = 0;
+  if (t)
+    t.close();
+
+  if (headSeg < 0) {
+    _oldest = _total = tail.seq;
+    return true;
+  }
+
+  // Walk back from the head through full, consecutive segments
+  uint32_t oldestOnDisk = headFirst;
+  uint16_t seg = headSeg;
+  for (uint16_t i = 1; i < _segments; i++) {
+    seg = (seg + _segments - 1) % _segments;
+    uint32_t first, stored;
+    if (!readSegment(seg, first, stored) || stored != _perSegment ||
+        first + _perSegment != oldestOnDisk)
+      break;
+    oldestOnDisk = first;
+  }
+
+  _total = headFirst + headStored;
+  _oldest = oldestOnDisk;
+  if (tail.seq > _oldest)
+    _oldest = tail.seq;
+  if (_oldest > _total)
+    _total = _oldest;
+  if (_total - _oldest > _capacity)
+    _oldest = _total - _capacity;
+
+  // Reopen the head, cutting off a record torn by a reset mid-append
+  char name[32];
+  segmentPath(headSeg, name);
+  _head = LittleFS.open(name, "r+");
+  if (!_head)
+    return false;
+  _headFirst = headFirst;
+  _headOpen = true;
+  uint32_t end = sizeof(SegmentHeader) + headStored * (uint32_t)_recordSize;
+  if (_head.size() > end) {
+    Serial.printf("[Ring] Truncating torn record in %s\n", name);
+    _head.truncate(end);
+  }
+  return true;
+}
+
+/// One-time import of the version 1 layout: a single preallocated file
+/// with head/tail in a header at offset 0. Sequence numbers carry on.
+void RingFile::importLegacy() {
+  struct LegacyHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t count;
+    uint32_t total;
+  } h;
+
+  uint8_t rec[256];
+  File f = LittleFS.open(_path, "r");
+  if (_recordSize <= sizeof(rec) && f &&
+      f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && h.magic == RING_MAGIC && h.version == 1 &&
+      h.recordSize == _recordSize && h.count <= h.capacity &&
+      h.count <= h.total) {
+    uint32_t n = h.count < _capacity ? h.count : _capacity;
+    _oldest = _total = h.total - n;
+    for (uint32_t i = h.count - n; i < h.count; i++) {
+      uint32_t slot = (h.tail + i) % h.capacity;
+      if (!f.seek(sizeof(h) + slot * (uint32_t)_recordSize, SeekSet) ||
+          f.read(rec, _recordSize) != _recordSize ||
+          !writeRecords(rec, 1))
+        break;
+      yield();
+    }
+    if (_headOpen)
+      _head.flush();
+    Serial.printf("[Ring] Imported %u records from %s\n", (unsigned)count(),
+                  _path);
+  }
+  if (f)
+    f.close();
+  LittleFS.remove(_path);
+}
+
+bool RingFile::writeTail() {
+  char name[32];
+  snprintf(name, sizeof(name), "%s.t", _path);
+  File f = LittleFS.open(name, "w");
+  if (!f)
+    return false;
+  TailFile t = {TAIL_MAGIC, _oldest};
+  bool ok = f.write((const uint8_t *)&t, sizeof(t)) == sizeof(t);
+  f.close();
+  return ok;
+}
+
+/// Make `_head` the segment that holds `seq`, starting it afresh if it
+/// currently holds older records.
+bool RingFile::openHead(uint32_t seq) {
+  uint32_t firstSeq = seq - seq % _perSegment;
+  if (_headOpen && _headFirst == firstSeq)
+    return true;
+
+  if (_headOpen) {
+    _head.close();
+    _headOpen = false;
+  }
+  uint16_t seg = segmentOf(seq);
+  if (_readerOpen && segmentOf(_readerFirst) == seg) {
+    _reader.close();
+    _readerOpen = false;
+  }
+
+  char name[32];
+  segmentPath(seg, name);
+  _head = LittleFS.open(name, "w+");
+  if (!_head) {
+    Serial.printf("[Ring] Cannot create %s\n", name);
+    return false;
+  }
+  SegmentHeader h = {RING_MAGIC, RING_VERSION, _recordSize, firstSeq};
+  if (_head.write((const uint8_t *)&h, sizeof(h)) != sizeof(h))
+    return false;
+  _headFirst = firstSeq;
+  _headOpen = true;
+  return true;
+}
+
+/// Write records at the head without syncing.
+bool RingFile::writeRecords(const uint8_t *records, uint32_t n) {
+  while (n > 0) {
+    if (!openHead(_total))
+      return false;
+    // As many as fit in this segment in one write
+    uint32_t room = _perSegment - _total % _perSegment;
+    uint32_t k = n < room ? n : room;
+    uint32_t offset = offsetOf(_total);
+    if (_head.size() < offset) {
+      // Starting mid-segment (after clear()): pad up to the slot
+      uint8_t zeros[16] = {0};
+      _head.seek(0, SeekEnd);
+      for (uint32_t pad = offset - _head.size(); pad > 0;) {
+        uint32_t z = pad < sizeof(zeros) ? pad : sizeof(zeros);
+        _head.write(zeros, z);
+        pad -= z;
+      }
+    }
+    size_t bytes = k * (size_t)_recordSize;
+    if (!_head.seek(offset, SeekSet) || _head.write(records, bytes) != bytes)
+      return false;
+
+    _total += k;
+    if (_total - _oldest > _capacity)
+      _oldest = _total - _capacity;
+    records += bytes;
+    n -= k;
+  }
+  return true;
+}
+
+bool RingFile::append(const void *record) { return appendMany(record, 1); }
+
+bool RingFile::appendMany(const void *records, uint32_t n) {
+  if (n == 0)
+    return true;
+  bool ok = writeRecords((const uint8_t *)records, n);
+  if (_headOpen)
+    _head.flush();
+  return ok;
+}
+
+bool RingFile::updateLast(const void *record) {
+  if (count() == 0 || !_headOpen || _total - 1 < _headFirst)
+    return false;
+  if (!_head.seek(offsetOf(_total - 1), SeekSet) ||
+      _head.write((const uint8_t *)record, _recordSize) != _recordSize)
+    return false;
+  _head.flush();
+  return true;
+}
+
+/// Open handle on the segment holding `seq`.
+File *RingFile::fileFor(uint32_t seq) {
+  uint32_t firstSeq = seq - seq % _perSegment;
+  if (_headOpen && _headFirst == firstSeq)
+    return &_head;
+  if (_readerOpen && _readerFirst == firstSeq)
+    return &_reader;
+
+  if (_readerOpen)
+    _reader.close();
+  char name[32];
+  segmentPath(segmentOf(seq), name);
+  _reader = LittleFS.open(name, "r");
+  _readerOpen = (bool)_reader;
+  _readerFirst = firstSeq;
+  return _readerOpen ? &_reader : nullptr;
+}
+
+bool RingFile::read(uint32_t index, void *record) {
+  return read(index, record, 0, _recordSize);
+}
+
+bool RingFile::read(uint32_t index, void *buf, uint16_t offset, uint16_t len) {
+  if (index >= count() || offset + len > _recordSize)
+    return false;
+  uint32_t seq = _oldest + index;
+  File *f = fileFor(seq);
+  if (!f || !f->seek(offsetOf(seq) + offset, SeekSet))
+    return false;
+  return f->read((uint8_t *)buf, len) == len;
+}
+
+void RingFile::dropOldest(uint32_t n, bool persist) {
+  if (n > count())
+    n = count();
+  if (n == 0)
+    return;
+  _oldest += n;
+  _tailDirty = true;
+  if (persist)
+    syncTail();
+}
+
+bool RingFile::syncTail() {
+  if (!_tailDirty)
+    return true;
+  _tailDirty = !writeTail();
+  return !_tailDirty;
+}
+
+void RingFile::clear() {
+  _oldest = _total;
+  _tailDirty = !writeTail();
+}
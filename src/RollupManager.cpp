@@ -0,0 +1,127 @@
+#include "RollupManager.h"
+#include "ArchiveManager.h"
+#include "Config.h"
+#include "RingFile.h"
+#include "StorageManager.h"
+
+struct Tier {
+  const char *name;
+  uint32_t widthS;
+  RingFile ring;
+  RollupMgr::Bucket open; // being filled, in RAM only
+  bool hasOpen;
+  uint32_t closedEnd; // end of the newest bucket on flash
+};
+
+static Tier tiers[RollupMgr::RESOLUTION_COUNT] = {
+    {"minute", 60UL,
+     RingFile(ROLLUP_MINUTE_PATH, sizeof(RollupMgr::Bucket),
+              ROLLUP_MINUTE_CAPACITY),
+     {}, false, 0},
+    {"hour", 3600UL,
+     RingFile(ROLLUP_HOUR_PATH, sizeof(RollupMgr::Bucket),
+              ROLLUP_HOUR_CAPACITY),
+     {}, false, 0},
+    {"day", 86400UL,
+     RingFile(ROLLUP_DAY_PATH, sizeof(RollupMgr::Bucket), ROLLUP_DAY_CAPACITY),
+     {}, false, 0},
+};
+
+void RollupMgr::begin() {
+  uint32_t resumeFrom = UINT32_MAX;
+  for (Tier &t : tiers) {
+    t.hasOpen = false;
+    t.closedEnd = 0;
+    if (!t.ring.begin())
+      continue;
+    uint32_t n = t.ring.count();
+    Bucket last;
+    if (n > 0 && t.ring.read(n - 1, &last))
+      t.closedEnd = last.start + t.widthS;
+    if (t.closedEnd < resumeFrom)
+      resumeFrom = t.closedEnd;
+    Serial.printf("[Rollup] %s: %u/%u buckets\n", t.name, (unsigned)n,
+                  (unsigned)t.ring.capacity());
+  }
+
+  // The open buckets were lost with RAM; rebuild them from the archive,
+  // going back no further than the start of the newest day
+  StorageMgr::Reading newest;
+  int entries = StorageMgr::getEntryCount();
+  if (entries == 0 || !StorageMgr::getReading(entries - 1, newest))
+    return;
+  uint32_t dayStart = newest.epoch - newest.epoch % tiers[DAY].widthS;
+  if (resumeFrom < dayStart)
+    resumeFrom = dayStart;
+  ArchiveMgr::Reader r(resumeFrom);
+  uint32_t epoch, replayed = 0;
+  float cm;
+  while (r.next(epoch, cm)) {
+    addReading(epoch, cm);
+    replayed++;
+  }
+  Serial.printf("[Rollup] %lu readings replayed\n", (unsigned long)replayed);
+}
+
+void RollupMgr::addReading(unsigned long epochSeconds, float distanceCm) {
+  for (Tier &t : tiers) {
+    uint32_t start = (uint32_t)(epochSeconds - epochSeconds % t.widthS);
+
+    // Clock stepped backwards: never reopen a closed bucket
+    if (start < t.closedEnd || (t.hasOpen && start < t.open.start))
+      continue;
+
+    Bucket &b = t.open;
+    if (t.hasOpen && b.start == start) {
+      b.count++;
+      if (distanceCm < b.min)
+        b.min = distanceCm;
+      if (distanceCm > b.max)
+        b.max = distanceCm;
+      b.mean += (distanceCm - b.mean) / b.count;
+      b.last = distanceCm;
+      continue;
+    }
+
+    if (t.hasOpen) {
+      if (!t.ring.append(&b))
+        Serial.printf("[Rollup] %s bucket write FAILED!\n", t.name);
+      t.closedEnd = b.start + t.widthS;
+    }
+    b.start = start;
+    b.min = b.max = b.mean = b.last = distanceCm;
+    b.count = 1;
+    t.hasOpen = true;
+  }
+}
+
+int RollupMgr::getBucketCount(Resolution res) {
+  if (res >= RESOLUTION_COUNT)
+    return 0;
+  return (int)tiers[res].ring.count() + (tiers[res].hasOpen ? 1 : 0);
+}
+
+bool RollupMgr::getBucket(Resolution res, int index, Bucket &out) {
+  if (res >= RESOLUTION_COUNT || index < 0)
+    return false;
+  Tier &t = tiers[res];
+  if ((uint32_t)index == t.ring.count() && t.hasOpen) {
+    out = t.open;
+    return true;
+  }
+  return t.ring.read((uint32_t)index, &out);
+}
+
+bool RollupMgr::parseResolution(const String &name, Resolution &out) {
+  for (uint8_t i = 0; i < RESOLUTION_COUNT; i++) {
+    if (name == tiers[i].name) {
+      out = (Resolution)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *RollupMgr::resolutionName(Resolution res) {
+  return res < RESOLUTION_COUNT ? tiers[res].name : "raw";
+}
@@ -0,0 +1,138 @@
+#include "SamplingManager.h"
+#include "Config.h"
+
+namespace SamplingMgr {
+
+struct Point {
+  unsigned long ms;
+  float cm;
+};
+
+static Point window[SAMPLE_TREND_WINDOW];
+static uint8_t windowLen = 0;
+static uint8_t windowHead = 0; // next slot to write
+
+static uint32_t ceilingMs =
+    SAMPLE_ADAPTIVE ? SAMPLE_MAX_INTERVAL_MS : SENSOR_READ_INTERVAL_MS;
+static uint32_t currentMs = SAMPLE_MIN_INTERVAL_MS; // fast until a trend exists
+static float riseCmPerS = 0;
+static Reason currentReason = BY_CEILING;
+
+/// Least-squares slope of distance over time, negated so rising water is
+/// positive. Needs three points to say anything about the trend.
+static float fitRiseRate() {
+  if (windowLen < 3)
+    return 0;
+  uint8_t oldest = (windowHead + SAMPLE_TREND_WINDOW - windowLen) %
+                   SAMPLE_TREND_WINDOW;
+  unsigned long t0 = window[oldest].ms;
+  float sumT = 0, sumC = 0, sumTT = 0, sumTC = 0;
+  for (uint8_t i = 0; i < windowLen; i++) {
+    const Point &p = window[(oldest + i) % SAMPLE_TREND_WINDOW];
+    float t = (p.ms - t0) / 1000.0f;
+    sumT += t;
+    sumC += p.cm;
+    sumTT += t * t;
+    sumTC += t * p.cm;
+  }
+  float denom = windowLen * sumTT - sumT * sumT;
+  if (denom <= 0)
+    return 0;
+  return -(windowLen * sumTC - sumT * sumC) / denom;
+}
+
+uint32_t update(unsigned long nowMs, float distanceCm, float warnCm,
+                float alarmCm, bool rainExpected) {
+  if (!SAMPLE_ADAPTIVE) {
+    currentMs = ceilingMs;
+    currentReason = BY_FIXED;
+    return currentMs;
+  }
+
+  window[windowHead] = {nowMs, distanceCm};
+  windowHead = (windowHead + 1) % SAMPLE_TREND_WINDOW;
+  if (windowLen < SAMPLE_TREND_WINDOW)
+    windowLen++;
+  riseCmPerS = fitRiseRate();
+
+  uint32_t target = ceilingMs;
+  Reason why = BY_CEILING;
+
+  if (rainExpected && SAMPLE_RAIN_INTERVAL_MS < target) {
+    target = SAMPLE_RAIN_INTERVAL_MS;
+    why = BY_RAIN;
+  }
+
+  float margin = distanceCm - warnCm; // cm of headroom above the warning
+  if (distanceCm <= alarmCm || margin <= 0) {
+    target = SAMPLE_MIN_INTERVAL_MS;
+    why = BY_THRESHOLD;
+  } else {
+    if (margin < SAMPLE_NEAR_MARGIN_CM) {
+      uint32_t near = SAMPLE_MIN_INTERVAL_MS +
+                      (uint32_t)((SAMPLE_MAX_INTERVAL_MS - SAMPLE_MIN_INTERVAL_MS) *
+                                 (margin / SAMPLE_NEAR_MARGIN_CM));
+      if (near < target) {
+        target = near;
+        why = BY_NEAR;
+      }
+    }
+    if (riseCmPerS > 0) {
+      float secondsToWarning = margin / riseCmPerS;
+      float rising = secondsToWarning * 1000.0f / SAMPLE_STEPS_TO_WARNING;
+      if (rising < target) {
+        target = (uint32_t)rising;
+        why = BY_RISE;
+      }
+    }
+  }
+
+  if (target < SAMPLE_MIN_INTERVAL_MS)
+    target = SAMPLE_MIN_INTERVAL_MS;
+  // Back off gradually so one quiet reading doesn't end a fast phase
+  if (target > currentMs * 2)
+    target = currentMs * 2;
+
+  if (target != currentMs || why != currentReason) {
+    Serial.printf("[Sampling] %lu s -> %lu s (%s, rise %s cm/h)\n",
+                  (unsigned long)(currentMs / 1000),
+                  (unsigned long)(target / 1000), reasonName(why),
+                  String(riseRateCmPerHour(), 1).c_str());
+  }
+  currentMs = target;
+  currentReason = why;
+  return currentMs;
+}
+
+void resume(uint32_t ms) {
+  currentMs = ms < SAMPLE_MIN_INTERVAL_MS ? SAMPLE_MIN_INTERVAL_MS : ms;
+}
+
+void setCeilingMs(uint32_t ms) {
+  ceilingMs = ms < SAMPLE_MIN_INTERVAL_MS ? SAMPLE_MIN_INTERVAL_MS : ms;
+}
+
+uint32_t intervalMs() { return currentMs; }
+
+float riseRateCmPerHour() { return riseCmPerS * 3600.0f; }
+
+Reason reason() { return currentReason; }
+
+const char *reasonName(Reason r) {
+  switch (r) {
+  case BY_CEILING:
+    return "calm";
+  case BY_RAIN:
+    return "rain";
+  case BY_NEAR:
+    return "near threshold";
+  case BY_RISE:
+    return "rising";
+  case BY_THRESHOLD:
+    return "warning/alarm";
+  default:
+    return "fixed";
+  }
+}
+
+} // namespace SamplingMgr
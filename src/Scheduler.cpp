@@ -0,0 +1,118 @@
+#include "Scheduler.h"
+#include "Config.h"
+
+namespace Scheduler {
+
+struct Task {
+  TaskInfo info;
+  TaskFn fn;
+  unsigned long nextDue;
+  bool armed; // periodic tasks always; event tasks once triggered
+};
+
+static Task tasks[SCHED_MAX_TASKS];
+static uint8_t count = 0;
+static uint32_t idleTotalMs = 0;
+
+static bool isDue(const Task &t, unsigned long now) {
+  return t.armed && (long)(now - t.nextDue) >= 0;
+}
+
+TaskId add(const char *name, TaskFn fn, uint32_t periodMs, Priority priority,
+           uint32_t deadlineMs) {
+  if (count >= SCHED_MAX_TASKS) {
+    Serial.printf("[Sched] No slot for task %s\n", name);
+    return INVALID_TASK;
+  }
+  Task &t = tasks[count];
+  memset(&t.info, 0, sizeof(t.info));
+  t.info.name = name;
+  t.info.periodMs = periodMs;
+  t.info.deadlineMs = deadlineMs;
+  t.info.priority = priority;
+  t.fn = fn;
+  t.nextDue = millis() + periodMs;
+  t.armed = periodMs > 0;
+  return (TaskId)count++;
+}
+
+void trigger(TaskId id) { triggerIn(id, 0); }
+
+void triggerIn(TaskId id, uint32_t delayMs) {
+  if (id < 0 || id >= count)
+    return;
+  Task &t = tasks[id];
+  unsigned long due = millis() + delayMs;
+  if (!t.armed || (long)(t.nextDue - due) > 0)
+    t.nextDue = due;
+  t.armed = true;
+}
+
+void setPeriod(TaskId id, uint32_t periodMs) {
+  if (id < 0 || id >= count || periodMs == 0)
+    return;
+  tasks[id].info.periodMs = periodMs;
+  tasks[id].nextDue = millis() + periodMs;
+  tasks[id].armed = true;
+}
+
+bool runNext() {
+  unsigned long now = millis();
+  Task *best = nullptr;
+  for (uint8_t i = 0; i < count; i++) {
+    Task &t = tasks[i];
+    if (!isDue(t, now))
+      continue;
+    if (!best || t.info.priority < best->info.priority ||
+        (t.info.priority == best->info.priority &&
+         (long)(t.nextDue - best->nextDue) < 0))
+      best = &t;
+  }
+  if (!best)
+    return false;
+
+  TaskInfo &info = best->info;
+  uint32_t lateness = now - best->nextDue;
+  if (lateness > info.maxLatenessMs)
+    info.maxLatenessMs = lateness;
+  if (info.deadlineMs > 0 && lateness > info.deadlineMs)
+    info.missedDeadlines++;
+  info.runs++;
+
+  // Reschedule before running so the task may trigger() itself
+  if (info.periodMs > 0) {
+    best->nextDue += info.periodMs;
+    if ((long)(now - best->nextDue) >= 0)
+      best->nextDue = now + info.periodMs; // fell behind: skip, don't burst
+  } else {
+    best->armed = false;
+  }
+
+  best->fn(now);
+  return true;
+}
+
+void idle() {
+  unsigned long now = millis();
+  uint32_t wait = SCHED_MAX_IDLE_MS;
+  for (uint8_t i = 0; i < count; i++) {
+    if (!tasks[i].armed)
+      continue;
+    long until = (long)(tasks[i].nextDue - now);
+    if (until <= 0)
+      return;
+    if ((uint32_t)until < wait)
+      wait = until;
+  }
+  // delay() hands the CPU to the SDK, which lets the modem sleep in between
+  delay(wait);
+  idleTotalMs += wait;
+}
+
+uint8_t taskCount() { return count; }
+
+const TaskInfo &getTask(uint8_t index) { return tasks[index].info; }
+
+uint32_t idleMs() { return idleTotalMs; }
+
+} // namespace Scheduler
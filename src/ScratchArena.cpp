@@ -0,0 +1,78 @@
+#include "ScratchArena.h"
+#include "Config.h"
+
+// Every block starts with its size, padded so the data stays aligned
+static const size_t ALIGN = 8;
+static const size_t HEAD = ALIGN;
+
+static size_t roundUp(size_t n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+
+void *ScratchArena::allocate(size_t size) {
+  size_t need = HEAD + roundUp(size);
+  if (need > _size - _top) {
+    _fallbacks++;
+    return malloc(size);
+  }
+  uint8_t *block = _buf + _top;
+  *(size_t *)block = size;
+  _last = _top;
+  _top += need;
+  _live++;
+  if (_top > _highWater)
+    _highWater = _top;
+  return block + HEAD;
+}
+
+void ScratchArena::deallocate(void *ptr) {
+  if (!ptr)
+    return;
+  if (!owns(ptr)) {
+    free(ptr);
+    return;
+  }
+  size_t offset = (uint8_t *)ptr - HEAD - _buf;
+  if (--_live == 0) {
+    _top = 0; // everything released: start over
+    _last = SIZE_MAX;
+  } else if (offset == _last) {
+    _top = _last;
+    _last = SIZE_MAX;
+  }
+}
+
+void *ScratchArena::reallocate(void *ptr, size_t newSize) {
+  if (!ptr)
+    return allocate(newSize);
+  if (!owns(ptr))
+    return realloc(ptr, newSize);
+
+  uint8_t *block = (uint8_t *)ptr - HEAD;
+  size_t oldSize = *(size_t *)block;
+  size_t offset = block - _buf;
+  if (offset == _last) {
+    // Newest block (e.g. a string being built): resize in place
+    size_t need = HEAD + roundUp(newSize);
+    if (need <= _size - _last) {
+      *(size_t *)block = newSize;
+      _top = _last + need;
+      if (_top > _highWater)
+        _highWater = _top;
+      return ptr;
+    }
+  } else if (newSize <= oldSize) {
+    return ptr;
+  }
+
+  void *moved = allocate(newSize);
+  if (!moved)
+    return nullptr;
+  memcpy(moved, ptr, oldSize < newSize ? oldSize : newSize);
+  deallocate(ptr);
+  return moved;
+}
+
+ScratchArena &ScratchArena::shared() {
+  alignas(8) static uint8_t storage[SCRATCH_ARENA_SIZE];
+  static ScratchArena arena(storage, sizeof(storage));
+  return arena;
+}
@@ -0,0 +1,115 @@
+#include "SensorFilter.h"
+#include "SensorManager.h"
+
+static_assert(SENSOR_HAMPEL_WINDOW >= 3 && SENSOR_HAMPEL_WINDOW <= 16,
+              "Hampel window must fit the 16-bit outcome history");
+
+void SensorFilter::reset() {
+  _est = {-1.0f, 0.0f, 0.0f};
+  _initialised = false;
+  _innovLen = 0;
+  _innovHead = 0;
+  _sigma = SENSOR_HAMPEL_MIN_CM;
+  _outcomes = 0;
+  _outcomeLen = 0;
+}
+
+/// Advance the tracker to `nowMs` along its current rate.
+void SensorFilter::predict(unsigned long nowMs, float &dtS) {
+  dtS = (nowMs - _lastMs) / 1000.0f;
+  _est.distanceCm += _est.rateCmPerS * dtS;
+  _lastMs = nowMs;
+}
+
+void SensorFilter::recordOutcome(bool hit) {
+  _outcomes = (uint16_t)((_outcomes << 1) | (hit ? 1 : 0));
+  if (_outcomeLen < WINDOW)
+    _outcomeLen++;
+
+  uint8_t hits = 0;
+  for (uint8_t i = 0; i < _outcomeLen; i++)
+    hits += (_outcomes >> i) & 1;
+  float hitRatio = (float)hits / _outcomeLen;
+  // 1.0 at the sensor's resolution, 0.5 once the spread is 3x that
+  float spread = 2.0f * SENSOR_HAMPEL_MIN_CM / (SENSOR_HAMPEL_MIN_CM + _sigma);
+  _est.confidence = _initialised ? hitRatio * spread : 0.0f;
+}
+
+SensorFilter::Result SensorFilter::update(unsigned long nowMs,
+                                          float measuredCm) {
+  if (measuredCm <= 0) {
+    if (_initialised) {
+      float dt;
+      predict(nowMs, dt);
+    }
+    recordOutcome(false);
+    return PING_MISSED;
+  }
+
+  if (!_initialised) {
+    _est.distanceCm = measuredCm;
+    _est.rateCmPerS = 0;
+    _lastMs = nowMs;
+    _initialised = true;
+    recordOutcome(true);
+    return PING_ACCEPTED;
+  }
+
+  float dt;
+  predict(nowMs, dt);
+  float innovation = measuredCm - _est.distanceCm;
+
+  _innov[_innovHead] = innovation;
+  _innovHead = (_innovHead + 1) % WINDOW;
+  if (_innovLen < WINDOW)
+    _innovLen++;
+
+  // Hampel test; needs a few innovations before the spread means anything
+  bool outlier = false;
+  if (_innovLen >= 3) {
+    float sorted[WINDOW];
+    memcpy(sorted, _innov, sizeof(float) * _innovLen);
+    float med = SensorMgr::median(sorted, _innovLen);
+    for (uint8_t i = 0; i < _innovLen; i++)
+      sorted[i] = fabsf(sorted[i] - med);
+    float mad = SensorMgr::median(sorted, _innovLen);
+    _sigma = 1.4826f * mad; // MAD → standard deviation for Gaussian noise
+    if (_sigma < SENSOR_HAMPEL_MIN_CM)
+      _sigma = SENSOR_HAMPEL_MIN_CM;
+    outlier = fabsf(innovation - med) > SENSOR_HAMPEL_K * _sigma;
+  }
+
+  if (outlier) {
+    recordOutcome(false);
+    return PING_REJECTED;
+  }
+
+  if (_innovLen >= 3 && fabsf(innovation) > SENSOR_HAMPEL_K * _sigma) {
+    // Not an outlier, yet far from the prediction: most of the window agrees
+    // on a new level, so the tracker is biased. Re-acquire at the new level
+    // instead of creeping towards it with rejections along the way.
+    _est.distanceCm = measuredCm;
+    _est.rateCmPerS = 0;
+    _innovLen = 0;
+    _innovHead = 0;
+    recordOutcome(true);
+    return PING_ACCEPTED;
+  }
+
+  _est.distanceCm += SENSOR_TRACK_ALPHA * innovation;
+  // Confirmation pings follow PING_GAP_MS after the last one: noise divided
+  // by 60 ms would swamp the rate that calm ticks extrapolate for minutes.
+  // The rate only learns from regular ticks, never over less than one.
+  if (dt * 1000.0f >= SENSOR_READ_INTERVAL_MS / 2) {
+    float rateDt = dt * 1000.0f < SENSOR_READ_INTERVAL_MS
+                       ? SENSOR_READ_INTERVAL_MS / 1000.0f
+                       : dt;
+    _est.rateCmPerS += SENSOR_TRACK_BETA * innovation / rateDt;
+    if (_est.rateCmPerS > SENSOR_MAX_RATE_CM_S)
+      _est.rateCmPerS = SENSOR_MAX_RATE_CM_S;
+    else if (_est.rateCmPerS < -SENSOR_MAX_RATE_CM_S)
+      _est.rateCmPerS = -SENSOR_MAX_RATE_CM_S;
+  }
+  recordOutcome(true);
+  return PING_ACCEPTED;
+}
@@ -1,55 +1,217 @@
 #include "SensorManager.h"
 #include "Config.h"
+#include "SensorFilter.h"
+
+static const int NUM_SAMPLES = 5;
+static const unsigned long ECHO_TIMEOUT_US = 30000; // ~5 m max
+static const unsigned long PING_GAP_MS = 60;        // JSN-SR04T ring-down time
+
+// ─── ISR state ──────────────────────────────────────────────────────────────
+static volatile uint32_t echoRiseUs = 0;
+static volatile uint32_t echoWidthUs = 0;
+static volatile bool echoArmed = false;
+static volatile bool echoDone = false;
+
+// ─── Burst state (main loop only) ───────────────────────────────────────────
+static bool burstActive = false;
+static bool pingInFlight = false;
+static unsigned long lastPingMs = 0;
+static uint32_t pingStartUs = 0;
+static int pingsSent = 0;
+static int validCount = 0;
+static float samples[NUM_SAMPLES];
+static uint32_t lastResolvedUs = 0; // when the latest ping got its answer
+static uint32_t sampleDoneUs = 0;   // when the latest reading completed
+static SensorMgr::BurstCallback burstCallback = nullptr;
+
+// ─── Streaming filter (SENSOR_STREAM_FILTER) ────────────────────────────────
+// One ping per reading. A ping the filter rejects or misses is re-checked
+// right away with up to SENSOR_CONFIRM_PINGS more, so a real step is
+// confirmed within a few ring-down gaps instead of a few sample intervals.
+static SensorFilter filter;
+static int confirmsLeft = 0;
+static bool burstEcho = false; // any echo in the current reading
+
+/// Feed one ping to the filter. Returns true if another ping should follow.
+static bool feedFilter(float measuredCm) {
+    if (measuredCm > 0) burstEcho = true;
+    SensorFilter::Result r = filter.update(millis(), measuredCm);
+    if (r == SensorFilter::PING_ACCEPTED || confirmsLeft == 0) return false;
+    confirmsLeft--;
+    return true;
+}
+
+/// The tracker's estimate, or -1 like the burst median when nothing answered.
+static float filteredCm() {
+    return filter.ready() && burstEcho ? filter.estimate().distanceCm : -1.0f;
+}
+
+static void IRAM_ATTR onEchoChange() {
+    uint32_t now = micros();
+    if (!echoArmed) return;
+    if (digitalRead(PIN_ECHO) == HIGH) {
+        echoRiseUs = now;
+    } else if (echoRiseUs != 0) {
+        echoWidthUs = now - echoRiseUs;
+        echoArmed = false;
+        echoDone = true;
+    }
+}
 
 void SensorMgr::begin() {
     pinMode(PIN_TRIG, OUTPUT);
     pinMode(PIN_ECHO, INPUT);
     digitalWrite(PIN_TRIG, LOW);
+    attachInterrupt(digitalPinToInterrupt(PIN_ECHO), onEchoChange, CHANGE);
     Serial.println("[Sensor] JSN-SR04T initialized (Trig=" + String(PIN_TRIG) +
                    " Echo=" + String(PIN_ECHO) + ")");
 }
 
-/// Take a single distance reading.
-static float singleRead() {
+static void triggerPing() {
     digitalWrite(PIN_TRIG, LOW);
     delayMicroseconds(2);
     digitalWrite(PIN_TRIG, HIGH);
     delayMicroseconds(10);
     digitalWrite(PIN_TRIG, LOW);
+}
 
-    long duration = pulseIn(PIN_ECHO, HIGH, 30000); // 30 ms timeout (~5 m max)
-    if (duration == 0) return -1.0f;
+// Speed of sound ≈ 0.0343 cm/µs, round-trip → divide by 2
+static float echoToCm(unsigned long durationUs) {
+    return (durationUs * 0.0343f) / 2.0f;
+}
+
+float SensorMgr::median(float* values, int n) {
+    if (n == 0) return -1.0f;
+
+    // Simple insertion sort for median
+    for (int i = 1; i < n; i++) {
+        float key = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > key) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = key;
+    }
+    return values[n / 2];
+}
+
+/// Take a single distance reading.
+static float singleRead() {
+    // pulseIn does its own timing; keep the ISR out of the way
+    echoArmed = false;
+    triggerPing();
 
-    // Speed of sound ≈ 0.0343 cm/µs, round-trip → divide by 2
-    float dist = (duration * 0.0343f) / 2.0f;
-    return dist;
+    long duration = pulseIn(PIN_ECHO, HIGH, ECHO_TIMEOUT_US);
+    if (duration == 0) return -1.0f;
+    return echoToCm(duration);
 }
 
 float SensorMgr::readDistanceCm() {
-    const int NUM_SAMPLES = 5;
-    float samples[NUM_SAMPLES];
-    int validCount = 0;
+    if (SENSOR_STREAM_FILTER) {
+        confirmsLeft = SENSOR_CONFIRM_PINGS;
+        burstEcho = false;
+        while (feedFilter(singleRead())) delay(PING_GAP_MS);
+        sampleDoneUs = micros();
+        return filteredCm();
+    }
+
+    float values[NUM_SAMPLES];
+    int count = 0;
 
     for (int i = 0; i < NUM_SAMPLES; i++) {
         float d = singleRead();
         if (d > 0) {
-            samples[validCount++] = d;
+            values[count++] = d;
         }
         delay(30); // JSN-SR04T needs ~60 ms between readings, 30 ms is conservative overlap
     }
 
-    if (validCount == 0) return -1.0f;
+    sampleDoneUs = micros();
+    return SensorMgr::median(values, count);
+}
 
-    // Simple insertion sort for median
-    for (int i = 1; i < validCount; i++) {
-        float key = samples[i];
-        int j = i - 1;
-        while (j >= 0 && samples[j] > key) {
-            samples[j + 1] = samples[j];
-            j--;
+float SensorMgr::readMedianCm(int pings) {
+    float values[NUM_SAMPLES];
+    if (pings > NUM_SAMPLES) pings = NUM_SAMPLES;
+    int count = 0;
+    for (int i = 0; i < pings; i++) {
+        if (i > 0) delay(PING_GAP_MS);
+        float d = singleRead();
+        if (d > 0) values[count++] = d;
+    }
+    sampleDoneUs = micros();
+    // With two echoes this is the farther one: both must agree
+    return count > pings / 2 ? SensorMgr::median(values, count) : -1.0f;
+}
+
+// ─── Non-blocking acquisition ──────────────────────────────────────────────
+
+void SensorMgr::onBurstStart(BurstCallback callback) { burstCallback = callback; }
+
+void SensorMgr::requestReading() {
+    if (burstActive) return;
+    burstActive = true;
+    pingInFlight = false;
+    pingsSent = 0;
+    validCount = 0;
+    confirmsLeft = SENSOR_CONFIRM_PINGS;
+    burstEcho = false;
+    if (burstCallback) burstCallback();
+}
+
+bool SensorMgr::isBusy() { return burstActive; }
+
+uint32_t SensorMgr::lastSampleUs() { return sampleDoneUs; }
+
+bool SensorMgr::poll(float& outCm) {
+    if (!burstActive) return false;
+
+    if (pingInFlight) {
+        if (echoDone) {
+            noInterrupts();
+            uint32_t width = echoWidthUs;
+            lastResolvedUs = echoRiseUs + width; // falling edge
+            echoDone = false;
+            interrupts();
+            pingInFlight = false;
+            float cm = (width > 0 && width < ECHO_TIMEOUT_US) ? echoToCm(width) : -1.0f;
+            if (SENSOR_STREAM_FILTER) {
+                if (feedFilter(cm)) pingsSent = 0; // confirm with one more ping
+            } else if (cm > 0) {
+                samples[validCount++] = cm;
+            }
+        } else if (micros() - pingStartUs >= ECHO_TIMEOUT_US) {
+            echoArmed = false; // no echo: count it as a miss
+            pingInFlight = false;
+            lastResolvedUs = micros();
+            if (SENSOR_STREAM_FILTER && feedFilter(-1.0f)) pingsSent = 0;
+        } else {
+            return false;
         }
-        samples[j + 1] = key;
     }
 
-    return samples[validCount / 2]; // median
+    if (pingsSent < (SENSOR_STREAM_FILTER ? 1 : NUM_SAMPLES)) {
+        if (millis() - lastPingMs < PING_GAP_MS) return false;
+        echoRiseUs = 0;
+        echoDone = false;
+        echoArmed = true;
+        triggerPing();
+        pingStartUs = micros();
+        lastPingMs = millis();
+        pingsSent++;
+        pingInFlight = true;
+        return false;
+    }
+
+    burstActive = false;
+    sampleDoneUs = lastResolvedUs;
+    outCm = SENSOR_STREAM_FILTER ? filteredCm() : SensorMgr::median(samples, validCount);
+    return true;
+}
+
+float SensorMgr::rateCmPerS() { return filter.estimate().rateCmPerS; }
+
+float SensorMgr::confidence() {
+    return SENSOR_STREAM_FILTER ? filter.estimate().confidence : 1.0f;
 }
@@ -0,0 +1,112 @@
+#include "SettingsManager.h"
+#include "Config.h"
+#include <Preferences.h>
+
+static const uint8_t MAX_LISTENERS = 4;
+
+static Preferences prefs;
+static String stationName;
+static String riverName;
+static float warnCm = DEFAULT_WARNING_CM;
+static float alarmCm = DEFAULT_ALARM_CM;
+
+static bool dirty[SettingsMgr::KEY_COUNT] = {};
+static unsigned long lastChangeMs = 0;
+static SettingsMgr::ChangeCallback listeners[MAX_LISTENERS];
+static uint8_t listenerCount = 0;
+
+static void markChanged(SettingsMgr::Key key) {
+  dirty[key] = true;
+  lastChangeMs = millis();
+  for (uint8_t i = 0; i < listenerCount; i++)
+    listeners[i](key);
+}
+
+void SettingsMgr::begin() {
+  prefs.begin("wifi", true); // read-only
+  stationName = prefs.getString("station", "Antwerpen");
+  riverName = prefs.getString("river", "Schelde");
+  prefs.end();
+
+  prefs.begin("flood", false);
+  warnCm = prefs.getFloat("warn", DEFAULT_WARNING_CM);
+  alarmCm = prefs.getFloat("alarm", DEFAULT_ALARM_CM);
+  prefs.end();
+
+  Serial.printf("[Settings] Loaded: %s / %s, Warn=%.1f, Alarm=%.1f\n",
+                stationName.c_str(), riverName.c_str(), warnCm, alarmCm);
+}
+
+const String &SettingsMgr::station() { return stationName; }
+const String &SettingsMgr::river() { return riverName; }
+float SettingsMgr::warningThreshold() { return warnCm; }
+float SettingsMgr::alarmThreshold() { return alarmCm; }
+
+bool SettingsMgr::setStation(const String &value) {
+  if (value == stationName)
+    return false;
+  stationName = value;
+  markChanged(STATION);
+  return true;
+}
+
+bool SettingsMgr::setRiver(const String &value) {
+  if (value == riverName)
+    return false;
+  riverName = value;
+  markChanged(RIVER);
+  return true;
+}
+
+bool SettingsMgr::setWarningThreshold(float cm) {
+  if (cm == warnCm)
+    return false;
+  warnCm = cm;
+  markChanged(WARNING_CM);
+  return true;
+}
+
+bool SettingsMgr::setAlarmThreshold(float cm) {
+  if (cm == alarmCm)
+    return false;
+  alarmCm = cm;
+  markChanged(ALARM_CM);
+  return true;
+}
+
+void SettingsMgr::onChange(ChangeCallback callback) {
+  if (listenerCount < MAX_LISTENERS)
+    listeners[listenerCount++] = callback;
+}
+
+void SettingsMgr::loop() {
+  if (millis() - lastChangeMs >= SETTINGS_FLUSH_DELAY_MS)
+    flush();
+}
+
+void SettingsMgr::flush() {
+  if (dirty[STATION] || dirty[RIVER]) {
+    prefs.begin("wifi", false);
+    if (dirty[STATION])
+      prefs.putString("station", stationName);
+    if (dirty[RIVER])
+      prefs.putString("river", riverName);
+    prefs.end();
+  }
+  if (dirty[WARNING_CM] || dirty[ALARM_CM]) {
+    prefs.begin("flood", false);
+    if (dirty[WARNING_CM])
+      prefs.putFloat("warn", warnCm);
+    if (dirty[ALARM_CM])
+      prefs.putFloat("alarm", alarmCm);
+    prefs.end();
+  }
+
+  bool wrote = false;
+  for (bool &d : dirty) {
+    wrote |= d;
+    d = false;
+  }
+  if (wrote)
+    Serial.println("[Settings] Flushed to flash.");
+}
@@ -1,7 +1,61 @@
 #include "StorageManager.h"
 #include "Config.h"
+#include "RingFile.h"
+#include "RollupManager.h"
 #include <LittleFS.h>
-#include <vector>
+
+static RingFile ring(HISTORY_RING_PATH, sizeof(StorageMgr::Reading),
+                     HISTORY_RING_CAPACITY);
+static void (*appendCallback)(const StorageMgr::Reading &, uint32_t) = nullptr;
+static uint32_t lastEpoch = 0; // newest logged; the ring is sorted by epoch
+
+/// The binary searches need epochs that never decrease: refuse readings
+/// taken before NTP synced or after the clock stepped back.
+static bool acceptEpoch(uint32_t epoch) {
+  if (epoch < HISTORY_MIN_EPOCH) {
+    Serial.println("[Storage] Clock not synced yet, reading not logged");
+    return false;
+  }
+  if (epoch < lastEpoch) {
+    Serial.printf("[Storage] Clock stepped back (%lu < %lu), reading not "
+                  "logged\n",
+                  (unsigned long)epoch, (unsigned long)lastEpoch);
+    return false;
+  }
+  lastEpoch = epoch;
+  return true;
+}
+
+/// Sequence number of the oldest reading still in the ring.
+static uint32_t oldestSeq() { return ring.total() - ring.count(); }
+
+/// One-time import of the old line-based history.csv into the ring.
+static void importLegacyCSV() {
+  if (!LittleFS.exists(HISTORY_PATH))
+    return;
+
+  File f = LittleFS.open(HISTORY_PATH, "r");
+  if (!f)
+    return;
+
+  f.readStringUntil('\n'); // header
+  int imported = 0;
+  while (f.available()) {
+    String line = f.readStringUntil('\n');
+    int comma = line.indexOf(',');
+    if (comma > 0) {
+      StorageMgr::Reading r;
+      r.epoch = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+      r.distanceCm = line.substring(comma + 1).toFloat();
+      if (acceptEpoch(r.epoch) && ring.append(&r))
+        imported++;
+    }
+    yield();
+  }
+  f.close();
+  LittleFS.remove(HISTORY_PATH);
+  Serial.printf("[Storage] Imported %d rows from %s\n", imported, HISTORY_PATH);
+}
 
 void StorageMgr::begin() {
   if (!LittleFS.begin()) {
@@ -10,95 +64,234 @@ void StorageMgr::begin() {
   }
   Serial.println("[Storage] LittleFS mounted.");
 
-  // Create CSV with header if it doesn't exist
-  if (!LittleFS.exists(HISTORY_PATH)) {
-    File f = LittleFS.open(HISTORY_PATH, "w");
-    if (f) {
-      f.println("timestamp,distance_cm");
-      f.close();
-      Serial.println("[Storage] Created " + String(HISTORY_PATH));
-    }
-  } else {
-    Serial.println("[Storage] " + String(HISTORY_PATH) + " already exists.");
-  }
+  if (!ring.begin())
+    return;
+  Reading newest;
+  lastEpoch = ring.count() > 0 && ring.read(ring.count() - 1, &newest)
+                  ? newest.epoch
+                  : 0;
+  importLegacyCSV();
+  ArchiveMgr::begin();
+  Serial.printf("[Storage] History ring: %d/%d entries\n", getEntryCount(),
+                HISTORY_RING_CAPACITY);
+
+  RollupMgr::begin();
 }
 
 void StorageMgr::logReading(unsigned long epochSeconds, float distanceCm) {
-  int count = getEntryCount();
-
-  if (count < MAX_CSV_ENTRIES) {
-    // Just append
-    File f = LittleFS.open(HISTORY_PATH, "a");
-    if (f) {
-      f.printf("%lu,%.1f\n", epochSeconds, distanceCm);
-      f.close();
-    }
-    Serial.printf("[Storage] Appended: %lu, %.1f cm (%d/%d)\n", epochSeconds,
-                  distanceCm, count + 1, MAX_CSV_ENTRIES);
+  Reading r;
+  r.epoch = (uint32_t)epochSeconds;
+  r.distanceCm = distanceCm;
+
+  if (isnan(distanceCm) || isinf(distanceCm)) {
+    Serial.println("[Storage] Skipping non-finite reading");
     return;
   }
-
-  // Rotation needed: Copy header + all lines except the first data line to a
-  // temp file
-  Serial.println("[Storage] Rotating history...");
-  File src = LittleFS.open(HISTORY_PATH, "r");
-  File dst = LittleFS.open("/temp.csv", "w");
-
-  if (!src || !dst) {
-    if (src)
-      src.close();
-    if (dst)
-      dst.close();
+  if (!acceptEpoch(r.epoch))
+    return;
+  if (!ring.append(&r)) {
+    Serial.println("[Storage] Append FAILED!");
     return;
   }
+  Serial.printf("[Storage] Logged: %lu, %.1f cm (%d/%d)\n", epochSeconds,
+                distanceCm, getEntryCount(), HISTORY_RING_CAPACITY);
+
+  RollupMgr::addReading(epochSeconds, distanceCm);
+  ArchiveMgr::addReading(r.epoch, distanceCm);
+  if (appendCallback)
+    appendCallback(r, ring.total() - 1);
+}
+
+uint32_t StorageMgr::cursor() { return ring.total(); }
+
+void StorageMgr::onAppend(void (*callback)(const Reading &, uint32_t)) {
+  appendCallback = callback;
+}
+
+bool StorageMgr::getReading(int index, Reading &out) {
+  if (index < 0)
+    return false;
+  return ring.read((uint32_t)index, &out);
+}
+
+// ─── Time index ─────────────────────────────────────────────────────────────
+
+/// Sequence number of the first reading in [lo, hi) with epoch >= `epoch`.
+/// Readings are logged in time order, so the ring is sorted by epoch.
+static uint32_t lowerBound(uint32_t epoch, uint32_t lo, uint32_t hi) {
+  uint32_t first = oldestSeq();
+  StorageMgr::Reading r;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (ring.read(mid - first, &r) && r.epoch < epoch)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
 
-  // Copy header
-  String header = src.readStringUntil('\n');
-  dst.println(header);
+int StorageMgr::findFirstAtOrAfter(uint32_t epoch) {
+  uint32_t first = oldestSeq();
+  return (int)(lowerBound(epoch, first, ring.total()) - first);
+}
 
-  // Skip the first data line
-  src.readStringUntil('\n');
+StorageMgr::RangeReader::RangeReader(uint32_t from, uint32_t to,
+                                     uint32_t since) {
+  if (to < from) {
+    _next = _end = 0;
+    return;
+  }
+  uint32_t first = oldestSeq();
+  uint32_t total = ring.total();
+  if (since > total)
+    since = 0; // cursor from before the ring was recreated: start over
+  uint32_t lo = since > first ? since : first;
+
+  _next = lowerBound(from, lo, total);
+  _end = to == UINT32_MAX ? total : lowerBound(to + 1, _next, total);
+}
 
-  // Copy remaining lines
-  while (src.available()) {
-    String line = src.readStringUntil('\n');
-    if (line.length() > 0) {
-      dst.println(line);
+bool StorageMgr::RangeReader::next(Reading &out) {
+  while (_next < _end) {
+    uint32_t first = oldestSeq();
+    if (_next < first) {
+      _next = first; // overwritten while we were reading
+      continue;
     }
-    yield(); // Feed the watchdog
+    bool ok = ring.read(_next - first, &out);
+    _next++;
+    if (ok)
+      return true;
   }
+  return false;
+}
 
-  // Add new reading
-  dst.printf("%lu,%.1f\n", epochSeconds, distanceCm);
+// ─── Streaming history ──────────────────────────────────────────────────────
 
-  src.close();
-  dst.close();
+/// True if readings from `from` on are only still held by the archive.
+static bool needsArchive(uint32_t from, uint32_t since) {
+  StorageMgr::Reading oldest;
+  if (from == 0 || since > 0 || !ring.read(0, &oldest) || from >= oldest.epoch)
+    return false;
+  uint32_t archived = ArchiveMgr::oldestEpoch();
+  return archived != 0 && archived < oldest.epoch;
+}
 
-  // Swap files
-  LittleFS.remove(HISTORY_PATH);
-  LittleFS.rename("/temp.csv", HISTORY_PATH);
+StorageMgr::HistoryStream::HistoryStream(bool json, uint32_t from, uint32_t to,
+                                         uint32_t limit, uint32_t since)
+    : _json(json), _range(from, to, since),
+      _fromArchive(needsArchive(from, since)),
+      _archive(_fromArchive ? from : 1, _fromArchive ? to : 0) {
+  uint32_t count = _fromArchive ? _archive.remaining() : _range.remaining();
+  if (limit > 0 && count > limit)
+    _stride = (count + limit - 1) / limit;
+}
+
+/// Render the next piece of output into the scratch buffer.
+bool StorageMgr::HistoryStream::format() {
+  _pos = 0;
+  _len = 0;
+  switch (_phase) {
+  case HEADER:
+    _phase = ROWS;
+    if (!_json) {
+      _len = snprintf(_scratch, sizeof(_scratch), "timestamp,distance_cm\n");
+    } else if (_stride > 1) {
+      _len = snprintf(_scratch, sizeof(_scratch),
+                      "{\"unit\":\"cm\",\"stride\":%lu,\"data\":[",
+                      (unsigned long)_stride);
+    } else {
+      _len = snprintf(_scratch, sizeof(_scratch), "{\"unit\":\"cm\",\"data\":[");
+    }
+    return true;
+
+  case ROWS: {
+    // One output point per group: the reading with the highest water.
+    // Non-finite values (NaN/inf from a failed read) would be invalid JSON;
+    // a group holding nothing else is skipped.
+    Reading best = {0, 0}, r;
+    bool have = false;
+    while (!have) {
+      bool any = false;
+      for (uint32_t i = 0; i < _stride && nextReading(r); i++) {
+        any = true;
+        if (isnan(r.distanceCm) || isinf(r.distanceCm))
+          continue;
+        if (!have || r.distanceCm < best.distanceCm) {
+          best = r;
+          have = true;
+        }
+      }
+      if (!any) {
+        _phase = FOOTER;
+        return format();
+      }
+    }
+    if (_json) {
+      _len = snprintf(_scratch, sizeof(_scratch), "%s{\"ts\":%lu,\"val\":%.1f}",
+                      _emitted ? "," : "", (unsigned long)best.epoch,
+                      best.distanceCm);
+    } else {
+      _len = snprintf(_scratch, sizeof(_scratch), "%lu,%.1f\n",
+                      (unsigned long)best.epoch, best.distanceCm);
+    }
+    _emitted++;
+    return true;
+  }
 
-  Serial.printf("[Storage] Rotated: %lu, %.1f cm\n", epochSeconds, distanceCm);
+  case FOOTER:
+    _phase = DONE;
+    if (!_json)
+      return false;
+    _len = snprintf(_scratch, sizeof(_scratch), "],\"next\":%lu}",
+                    (unsigned long)_range.end());
+    return true;
+
+  default:
+    return false;
+  }
 }
 
-String StorageMgr::getCSV() {
-  File f = LittleFS.open(HISTORY_PATH, "r");
-  if (!f)
-    return "timestamp,distance_cm\n";
-  String content = f.readString();
-  f.close();
-  return content;
+bool StorageMgr::HistoryStream::nextReading(Reading &r) {
+  if (_fromArchive)
+    return _archive.next(r.epoch, r.distanceCm);
+  return _range.next(r);
 }
 
-int StorageMgr::getEntryCount() {
-  File f = LittleFS.open(HISTORY_PATH, "r");
-  if (!f)
-    return 0;
-  int count = -1; // subtract header
-  while (f.available()) {
-    f.readStringUntil('\n');
-    count++;
+size_t StorageMgr::HistoryStream::read(uint8_t *buf, size_t maxLen) {
+  size_t n = 0;
+  while (n < maxLen) {
+    if (_pos == _len && !format())
+      break;
+    size_t chunk = _len - _pos;
+    if (chunk > maxLen - n)
+      chunk = maxLen - n;
+    memcpy(buf + n, _scratch + _pos, chunk);
+    n += chunk;
+    _pos += chunk;
   }
-  f.close();
-  return count < 0 ? 0 : count;
+  return n;
 }
+
+/// Drain a stream into `out` through a small stack buffer.
+static void writeStream(StorageMgr::HistoryStream &stream, Print &out) {
+  uint8_t buf[128];
+  size_t n;
+  while ((n = stream.read(buf, sizeof(buf))) > 0) {
+    out.write(buf, n);
+    yield(); // long history reads must not trip the WDT
+  }
+}
+
+void StorageMgr::writeCSV(Print &out) {
+  HistoryStream stream(false);
+  writeStream(stream, out);
+}
+
+void StorageMgr::writeJSON(Print &out) {
+  HistoryStream stream(true);
+  writeStream(stream, out);
+}
+
+int StorageMgr::getEntryCount() { return (int)ring.count(); }
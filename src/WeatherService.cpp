@@ -1,54 +1,71 @@
 #include "WeatherService.h"
+#include "ConnectionPool.h"
+#include "TextBuffer.h"
 #include <ESP8266WiFi.h>
 #include <ESP8266HTTPClient.h>
 #include <WiFiClient.h>
 #include <ArduinoJson.h>
 
-static String _apiKey;
-static String _city;
-static String _country;
-static bool   _rainExpected  = false;
-static String _forecastDesc  = "Unknown";
+static const char* _apiKey  = "";
+static const char* _city    = "";
+static const char* _country = "";
+static bool        _rainExpected = false;
+static TextBuffer<48> _forecastDesc;
+
+static void setForecast(const char* text) {
+    _forecastDesc.clear();
+    _forecastDesc.print(text);
+}
 
 void WeatherSvc::begin(const char* apiKey, const char* city, const char* country) {
     _apiKey  = apiKey;
     _city    = city;
     _country = country;
-    Serial.println("[Weather] Initialized for " + _city + "," + _country);
+    setForecast("Unknown");
+    Serial.printf("[Weather] Initialized for %s,%s\n", _city, _country);
 }
 
 bool WeatherSvc::update() {
-    if (_apiKey.length() == 0 || _apiKey == "YOUR_OWM_API_KEY") {
+    if (_apiKey[0] == '\0' || strcmp(_apiKey, "YOUR_OWM_API_KEY") == 0) {
         Serial.println("[Weather] No valid API key configured — skipping.");
-        _forecastDesc = "No API key";
+        setForecast("No API key");
         return false;
     }
 
-    String url = "http://api.openweathermap.org/data/2.5/forecast?q=" +
-                 _city + "," + _country +
-                 "&cnt=1&appid=" + _apiKey;
+    TextBuffer<192> url;
+    url.printf("http://api.openweathermap.org/data/2.5/forecast?q=%s,%s&cnt=1&appid=%s",
+               _city, _country, _apiKey);
+
+    WiFiClient* client = ConnPool::acquire("api.openweathermap.org", 80, false);
+    if (!client) {
+        setForecast("No connection");
+        return false;
+    }
 
-    WiFiClient client;
     HTTPClient http;
-    http.begin(client, url);
+    http.setReuse(true);
+    http.begin(*client, url.c_str());
     int code = http.GET();
 
     if (code != 200) {
         Serial.printf("[Weather] HTTP error: %d\n", code);
         http.end();
-        _forecastDesc = "HTTP " + String(code);
+        ConnPool::release(client, false);
+        _forecastDesc.clear();
+        _forecastDesc.printf("HTTP %d", code);
         return false;
     }
 
     String payload = http.getString();
     http.end();
+    ConnPool::release(client);
 
     // Parse JSON
     JsonDocument doc;
     DeserializationError err = deserializeJson(doc, payload);
     if (err) {
         Serial.printf("[Weather] JSON parse error: %s\n", err.c_str());
-        _forecastDesc = "Parse error";
+        setForecast("Parse error");
         return false;
     }
 
@@ -57,14 +74,15 @@ bool WeatherSvc::update() {
     const char* description = doc["list"][0]["weather"][0]["description"];
 
     if (mainWeather) {
-        String mw = String(mainWeather);
-        _forecastDesc = description ? String(description) : mw;
-        _rainExpected = (mw == "Rain" || mw == "Thunderstorm" ||
-                         mw == "Drizzle" || mw == "Squall");
+        setForecast(description ? description : mainWeather);
+        _rainExpected = (strcmp(mainWeather, "Rain") == 0 ||
+                         strcmp(mainWeather, "Thunderstorm") == 0 ||
+                         strcmp(mainWeather, "Drizzle") == 0 ||
+                         strcmp(mainWeather, "Squall") == 0);
         Serial.printf("[Weather] Forecast: %s  Rain expected: %s\n",
                       _forecastDesc.c_str(), _rainExpected ? "YES" : "NO");
     } else {
-        _forecastDesc = "No data";
+        setForecast("No data");
         _rainExpected = false;
     }
 
@@ -75,6 +93,6 @@ bool WeatherSvc::isRainExpected() {
     return _rainExpected;
 }
 
-String WeatherSvc::getForecastDescription() {
-    return _forecastDesc;
+const char* WeatherSvc::getForecastDescription() {
+    return _forecastDesc.c_str();
 }
@@ -1,119 +1,332 @@
 #include "WebHandler.h"
 #include "CloudSync.h"
 #include "Config.h"
+#include "ConnectionPool.h"
+#include "LivePayload.h"
+#include "Metrics.h"
 #include "NotificationManager.h"
+#include "OutboxManager.h"
+#include "RollupManager.h"
+#include "ScratchArena.h"
+#include "SensorManager.h"
+#include "SettingsManager.h"
 #include "StorageManager.h"
+#include "TextBuffer.h"
 #include "WeatherService.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
-#include <Preferences.h>
 
 extern void setSimulation(bool active, float distance);
 extern void setAutoSimulation(bool enabled);
 extern void triggerManualSync();
-
-// Global migration flags from main.cpp
-extern bool volatile pendingMigration;
-extern String migOldStation;
-extern String migNewStation;
-extern String migRiver;
+extern void queueMigration(const String &oldName, const String &newName,
+                           const String &river);
 
 extern float currentDistance;
-extern float warningThreshold;
-extern float alarmThreshold;
 extern uint32_t currentIntervalMs;
 
+// ─── WebSocket snapshot publisher ───────────────────────────────────────────
+// broadcastLevel() only serializes when something visible changed, and then
+// sends just the changed fields ("delta"), with a periodic "full" keyframe so
+// clients that missed a frame resync.
+using LivePayload::Snapshot;
+
+static Snapshot published;
+static bool havePublished = false;
+static unsigned long lastKeyframeMs = 0;
+
+// ─── /api/status snapshot ───────────────────────────────────────────────────
+// The serialized status is kept between requests and only rebuilt when one of
+// its fields changed. Its ETag is a hash of the body, so it stays valid across
+// reboots and a polling client gets a bodiless 304 until something changes.
+//
+// The body lives in a static buffer; only a status that outgrows it (very
+// long station/river names) is kept on the heap.
+static Snapshot statusSnap;
+static int statusEntries = -1;
+static int statusConfidence = -1; // percent
+static char statusBuf[LIVE_JSON_MAX];
+static char *statusJson = statusBuf;
+static size_t statusLen = 0;
+static char statusETag[12];
+
+static void refreshStatusSnapshot() {
+
+  Snapshot cur;
+  cur.distance10 = lroundf(currentDistance * 10.0f);
+  cur.warning10 = lroundf(SettingsMgr::warningThreshold() * 10.0f);
+  cur.alarm10 = lroundf(SettingsMgr::alarmThreshold() * 10.0f);
+  cur.rainExpected = WeatherSvc::isRainExpected();
+  LivePayload::setText(cur, WeatherSvc::getForecastDescription());
+  cur.interval = currentIntervalMs / 1000; // in seconds
+
+  if (currentDistance <= 0) {
+    cur.status = "UNKNOWN";
+  } else if (currentDistance <= SettingsMgr::alarmThreshold()) {
+    cur.status = "ALARM";
+  } else if (currentDistance <= SettingsMgr::warningThreshold()) {
+    cur.status = "WARNING";
+  } else {
+    cur.status = "NORMAL";
+  }
+
+  int entries = StorageMgr::getEntryCount();
+  // Whole percent steps, so sensor jitter alone doesn't invalidate the ETag
+  int confidence = lroundf(SensorMgr::confidence() * 100.0f);
+  if (statusLen > 0 && entries == statusEntries &&
+      confidence == statusConfidence && cur == statusSnap)
+    return;
+
+  if (statusJson != statusBuf) {
+    free(statusJson);
+    statusJson = statusBuf;
+  }
+  statusLen = LivePayload::writeStatus(statusBuf, sizeof(statusBuf), cur,
+                                       entries, confidence);
+  if (statusLen >= sizeof(statusBuf)) {
+    char *big = (char *)malloc(statusLen + 1);
+    if (!big) {
+      statusLen = 0;
+      return;
+    }
+    statusJson = big;
+    LivePayload::writeStatus(statusJson, statusLen + 1, cur, entries,
+                             confidence);
+  }
+  statusSnap = cur;
+  statusEntries = entries;
+  statusConfidence = confidence;
+
+  uint32_t hash = LivePayload::fnv1a(statusJson, statusLen);
+  snprintf(statusETag, sizeof(statusETag), "\"%08lx\"", (unsigned long)hash);
+}
+
+/// Send the JSON written by `writeFn(buf, size)` to every WS client. It goes
+/// to a stack buffer first; a frame that doesn't fit there is written again
+/// straight into the message buffer shared by the clients.
+template <typename Fn>
+static bool sendFrame(AsyncWebSocket &ws, Fn writeFn) {
+  char frame[LIVE_JSON_MAX];
+  size_t len = writeFn(frame, sizeof(frame));
+  AsyncWebSocketMessageBuffer *buffer = ws.makeBuffer(len);
+  if (!buffer)
+    return false;
+  if (len < sizeof(frame))
+    memcpy(buffer->get(), frame, len);
+  else
+    writeFn((char *)buffer->get(), len + 1);
+  ws.textAll(buffer);
+  return true;
+}
+
+// ─── Dashboard shell ────────────────────────────────────────────────────────
+// scripts/compress_fs.py stores the page gzip'd, with its assets renamed by
+// content hash. The shell is revalidated by an ETag hashed from the file at
+// boot, so a reload over a weak link costs one bodiless 304; hashed assets
+// never change and are cached for a year.
+static bool shellGzip = false;
+static char shellETag[12];
+
+static void hashShell() {
+  File f = LittleFS.open(WEB_SHELL_GZ_PATH, "r");
+  shellGzip = (bool)f;
+  if (!shellGzip) {
+    Serial.println("[Web] " WEB_SHELL_GZ_PATH " missing, serving " WEB_SHELL_PATH);
+    return;
+  }
+  char buf[128];
+  uint32_t hash = LivePayload::fnv1a(nullptr, 0); // offset basis
+  size_t n;
+  while ((n = f.read((uint8_t *)buf, sizeof(buf))) > 0)
+    hash = LivePayload::fnv1a(buf, n, hash);
+  f.close();
+  snprintf(shellETag, sizeof(shellETag), "\"%08lx\"", (unsigned long)hash);
+}
+
+/// Stream one rollup tier as CSV or JSON.
+static void sendRollup(AsyncWebServerRequest *req, RollupMgr::Resolution res,
+                       bool json) {
+  AsyncResponseStream *response =
+      req->beginResponseStream(json ? "application/json" : "text/csv");
+  if (json) {
+    response->printf("{\"unit\":\"cm\",\"resolution\":\"%s\",\"data\":[",
+                     RollupMgr::resolutionName(res));
+  } else {
+    response->print("timestamp,min_cm,max_cm,mean_cm,last_cm,count\n");
+  }
+
+  int n = RollupMgr::getBucketCount(res);
+  int emitted = 0;
+  RollupMgr::Bucket b;
+  for (int i = 0; i < n; i++) {
+    if (!RollupMgr::getBucket(res, i, b))
+      break;
+    // "%.1f" prints nan/inf, which is not JSON: skip such a bucket
+    float sum = b.min + b.max + b.mean + b.last;
+    if (isnan(sum) || isinf(sum))
+      continue;
+    if (json) {
+      response->printf("%s{\"ts\":%lu,\"min\":%.1f,\"max\":%.1f,"
+                       "\"mean\":%.1f,\"last\":%.1f,\"n\":%lu}",
+                       emitted++ ? "," : "", (unsigned long)b.start, b.min,
+                       b.max, b.mean, b.last, (unsigned long)b.count);
+    } else {
+      response->printf("%lu,%.1f,%.1f,%.1f,%.1f,%lu\n",
+                       (unsigned long)b.start, b.min, b.max, b.mean, b.last,
+                       (unsigned long)b.count);
+    }
+    if (i % 10 == 9)
+      yield();
+  }
+
+  if (json)
+    response->print("]}");
+  req->send(response);
+}
+
 void WebHandler::begin(AsyncWebServer &server, AsyncWebSocket &ws) {
   // ── WebSocket ───────────────────────────────────────────────────────
+  ws.onEvent([](AsyncWebSocket *, AsyncWebSocketClient *, AwsEventType type,
+                void *, uint8_t *, size_t) {
+    if (type == WS_EVT_CONNECT)
+      havePublished = false; // next broadcast is a keyframe
+  });
   server.addHandler(&ws);
 
   // ── Serve dashboard from LittleFS ───────────────────────────────────
+  hashShell();
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *req) {
-    req->send(LittleFS, "/index.html", "text/html");
+    if (!shellGzip) {
+      req->send(LittleFS, WEB_SHELL_PATH, "text/html");
+      return;
+    }
+    AsyncWebServerResponse *response;
+    if (req->hasHeader("If-None-Match") &&
+        req->getHeader("If-None-Match")->value() == shellETag) {
+      response = req->beginResponse(304);
+    } else {
+      response = req->beginResponse(LittleFS, WEB_SHELL_GZ_PATH, "text/html");
+      response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", shellETag);
+    response->addHeader("Cache-Control", "no-cache");
+    req->send(response);
   });
+  // Serves name.js from name.js.gz with Content-Encoding: gzip
+  server.serveStatic(WEB_ASSET_DIR, LittleFS, WEB_ASSET_DIR)
+      .setCacheControl("public, max-age=31536000, immutable");
 
   // ── API: History (CSV or JSON) ──────────────────────────────────────
   server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest *req) {
-    if (req->hasParam("format") && req->getParam("format")->value() == "json") {
-      // Memory efficient JSON generation - STREAMING to avoid WDT resets
-      File f = LittleFS.open(HISTORY_PATH, "r");
-      if (!f) {
-        req->send(500, "text/plain", "File error");
+    bool json =
+        req->hasParam("format") && req->getParam("format")->value() == "json";
+
+    // Aggregated tiers: ?resolution=minute|hour|day
+    if (req->hasParam("resolution") &&
+        req->getParam("resolution")->value() != "raw") {
+      RollupMgr::Resolution res;
+      if (!RollupMgr::parseResolution(req->getParam("resolution")->value(),
+                                      res)) {
+        req->send(400, "text/plain", "Unknown resolution");
         return;
       }
+      sendRollup(req, res, json);
+      return;
+    }
 
-      AsyncResponseStream *response =
-          req->beginResponseStream("application/json");
-      response->print("{\"unit\":\"cm\",\"data\":[");
-
-      // Skip header
-      f.readStringUntil('\n');
-
-      bool first = true;
-      int count = 0;
-      while (f.available()) {
-        String line = f.readStringUntil('\n');
-        line.trim();
-        int comma = line.indexOf(',');
-        if (comma != -1) {
-          if (!first)
-            response->print(",");
-          response->print("{\"ts\":");
-          response->print(line.substring(0, comma));
-          response->print(",\"val\":");
-          response->print(line.substring(comma + 1));
-          response->print("}");
-          first = false;
-        }
-
-        // Periodic yield to prevent WDT reset during long history reads
-        if (++count % 10 == 0)
-          yield();
-      }
-      f.close();
+    // Raw readings, optionally ?from=&to= (epoch seconds), ?limit=N points
+    // and ?since=<cursor> for only what was logged after a previous call.
+    // Streamed in chunks straight from the ring so a full history never has
+    // to fit in the heap.
+    uint32_t from = 0, to = UINT32_MAX, limit = 0, since = 0;
+    if (req->hasParam("from"))
+      from = strtoul(req->getParam("from")->value().c_str(), nullptr, 10);
+    if (req->hasParam("to"))
+      to = strtoul(req->getParam("to")->value().c_str(), nullptr, 10);
+    if (req->hasParam("limit"))
+      limit = strtoul(req->getParam("limit")->value().c_str(), nullptr, 10);
+    if (req->hasParam("since"))
+      since = strtoul(req->getParam("since")->value().c_str(), nullptr, 10);
+    if (to < from) {
+      req->send(400, "text/plain", "'to' is before 'from'");
+      return;
+    }
 
-      response->print("]}");
+    if (req->hasParam("since") && since == StorageMgr::cursor()) {
+      // Client is up to date
+      AsyncWebServerResponse *response = req->beginResponse(304);
+      response->addHeader("X-History-Cursor", String(since));
       req->send(response);
-    } else {
-      // Default: Stream the CSV file directly from LittleFS
-      req->send(LittleFS, HISTORY_PATH, "text/csv");
+      return;
     }
+
+    StorageMgr::HistoryStream stream(json, from, to, limit, since);
+    AsyncWebServerResponse *response = req->beginChunkedResponse(
+        json ? "application/json" : "text/csv",
+        [stream](uint8_t *buf, size_t maxLen, size_t) mutable {
+          return stream.read(buf, maxLen);
+        });
+    response->addHeader("X-History-Cursor", String(stream.next()));
+    if (stream.stride() > 1)
+      response->addHeader("X-Downsample-Stride", String(stream.stride()));
+    req->send(response);
   });
 
   // ── API: Current status JSON (Enhanced for Mobile App) ──────────────
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *req) {
-    JsonDocument doc;
-    doc["distance"] = round(currentDistance * 10.0f) / 10.0f;
-    doc["warning"] = round(warningThreshold * 10.0f) / 10.0f;
-    doc["alarm"] = round(alarmThreshold * 10.0f) / 10.0f;
-    doc["rainExpected"] = WeatherSvc::isRainExpected();
-    doc["forecast"] = WeatherSvc::getForecastDescription();
-    doc["entries"] = StorageMgr::getEntryCount();
-
-    // Metadata from Preferences
-    Preferences prefs;
-    prefs.begin("wifi", true);
-    doc["station"] = prefs.getString("station", "Antwerpen");
-    doc["river"] = prefs.getString("river", "Schelde");
-    prefs.end();
-    doc["interval"] = currentIntervalMs / 1000; // in seconds
-
-    if (currentDistance <= 0) {
-      doc["status"] = "UNKNOWN";
-    } else if (currentDistance <= alarmThreshold) {
-      doc["status"] = "ALARM";
-    } else if (currentDistance <= warningThreshold) {
-      doc["status"] = "WARNING";
+    refreshStatusSnapshot();
+
+    AsyncWebServerResponse *response;
+    if (req->hasHeader("If-None-Match") &&
+        req->getHeader("If-None-Match")->value() == statusETag) {
+      response = req->beginResponse(304);
     } else {
-      doc["status"] = "NORMAL";
+      response = req->beginResponse(200, "application/json", statusJson);
     }
+    response->addHeader("ETag", statusETag);
+    response->addHeader("Cache-Control", "no-cache");
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    response->addHeader("Access-Control-Expose-Headers", "ETag");
+    req->send(response);
+  });
+
+  // ── API: Outbound connection stats ──────────────────────────────────
+  server.on("/api/net", HTTP_GET, [](AsyncWebServerRequest *req) {
+    const ConnPool::Stats &st = ConnPool::getStats();
+    JsonDocument doc(&ScratchArena::shared());
+    doc["connects"] = st.connects;
+    doc["handshakes"] = st.handshakes;
+    doc["resumeAttempts"] = st.resumeAttempts;
+    doc["reuses"] = st.reuses;
+    doc["evictions"] = st.evictions;
+    doc["smallBuffers"] = st.smallBuffers;
+    doc["failures"] = st.failures;
+
+    JsonObject outbox = doc["outbox"].to<JsonObject>();
+    outbox["depth"] = OutboxMgr::depth();
+    outbox["lagS"] = OutboxMgr::lagSeconds();
+    outbox["dropped"] = OutboxMgr::dropped();
+    outbox["replayed"] = OutboxMgr::replayed();
+
+    const NotificationMgr::Stats &ns = NotificationMgr::getStats();
+    JsonObject notify = doc["notify"].to<JsonObject>();
+    notify["depth"] = NotificationMgr::depth();
+    notify["sent"] = ns.sent;
+    notify["retries"] = ns.retries;
+    notify["dropped"] = ns.dropped;
+    notify["overflow"] = ns.overflow;
+    notify["coalesced"] = ns.coalesced;
 
     String json;
     serializeJson(doc, json);
+    req->send(200, "application/json", json);
+  });
 
-    AsyncWebServerResponse *response =
-        req->beginResponse(200, "application/json", json);
-    response->addHeader("Access-Control-Allow-Origin", "*");
+  // ── API: Loop stage latencies + heap (Prometheus text format) ───────
+  server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *req) {
+    AsyncResponseStream *response =
+        req->beginResponseStream("text/plain; version=0.0.4");
+    Metrics::writePrometheus(*response);
     req->send(response);
   });
 
@@ -136,9 +349,12 @@ void WebHandler::begin(AsyncWebServer &server, AsyncWebSocket &ws) {
   // ── API: Manual Notification (Post Message) ─────────────────────────
   server.on("/api/notify", HTTP_POST, [](AsyncWebServerRequest *req) {
     if (req->hasParam("message", true)) {
-      String msg = req->getParam("message", true)->value();
-      bool success = NotificationMgr::sendTelegram("📱 Mobile App: " + msg);
-      req->send(success ? 200 : 500, "text/plain", success ? "Sent" : "Failed");
+      TextBuffer<NOTIFY_TEXT_MAX> text;
+      text.print("📱 Mobile App: ");
+      text.print(req->getParam("message", true)->value());
+      // Delivered in the background; the request never waits on Telegram
+      bool queued = NotificationMgr::queueTelegram(text.c_str());
+      req->send(queued ? 202 : 503, "text/plain", queued ? "Queued" : "Unavailable");
     } else {
       req->send(400, "text/plain", "Missing message");
     }
@@ -155,23 +371,17 @@ void WebHandler::begin(AsyncWebServer &server, AsyncWebSocket &ws) {
       newRiver = req->getParam("river", true)->value();
 
     if (newStation.length() > 0) {
-      Preferences prefs;
-      prefs.begin("wifi", false);
-      String oldStation = prefs.getString("station", "Antwerpen");
+      String oldStation = SettingsMgr::station();
 
       // Trigger Cloud Migration if name changed (Deferred to main loop)
       if (newStation != oldStation) {
-        migOldStation = oldStation;
-        migNewStation = newStation;
-        migRiver = newRiver;
-        pendingMigration = true;
+        queueMigration(oldStation, newStation, newRiver);
         Serial.println("[Web] Migration queued for main loop.");
       }
 
-      prefs.putString("station", newStation);
+      SettingsMgr::setStation(newStation);
       if (newRiver.length() > 0)
-        prefs.putString("river", newRiver);
-      prefs.end();
+        SettingsMgr::setRiver(newRiver);
       req->send(200, "text/plain", "OK");
     } else {
       req->send(400, "text/plain", "Missing station name");
@@ -198,39 +408,59 @@ void WebHandler::begin(AsyncWebServer &server, AsyncWebSocket &ws) {
   Serial.println("[Web] Routes registered.");
 }
 
-void WebHandler::broadcastLevel(AsyncWebSocket &ws, float distanceCm,
+bool WebHandler::broadcastLevel(AsyncWebSocket &ws, float distanceCm,
                                 float warningThr, float alarmThr,
-                                bool rainExpected, const String &forecast) {
-  if (ws.count() == 0)
-    return;
+                                bool rainExpected, const char *forecast) {
+  if (ws.count() == 0) {
+    havePublished = false; // whoever connects next starts from a keyframe
+    return false;
+  }
 
-  JsonDocument doc;
-  doc["distance"] = round(distanceCm * 10.0f) / 10.0f;
-  doc["warning"] = round(warningThr * 10.0f) / 10.0f;
-  doc["alarm"] = round(alarmThr * 10.0f) / 10.0f;
-  doc["rainExpected"] = rainExpected;
-  doc["forecast"] = forecast;
-
-  // Metadata
-  Preferences prefs;
-  prefs.begin("wifi", true);
-  doc["station"] = prefs.getString("station", "Antwerpen");
-  doc["river"] = prefs.getString("river", "Schelde");
-  prefs.end();
-  doc["interval"] = currentIntervalMs / 1000;
+  Snapshot cur;
+  cur.distance10 = lroundf(distanceCm * 10.0f);
+  cur.warning10 = lroundf(warningThr * 10.0f);
+  cur.alarm10 = lroundf(alarmThr * 10.0f);
+  cur.rainExpected = rainExpected;
+  LivePayload::setText(cur, forecast);
+  cur.interval = currentIntervalMs / 1000;
 
   // Determine status
   if (distanceCm <= alarmThr) {
-    doc["status"] = "ALARM";
+    cur.status = "ALARM";
   } else if (distanceCm <= warningThr) {
-    doc["status"] = "WARNING";
+    cur.status = "WARNING";
   } else {
-    doc["status"] = "NORMAL";
+    cur.status = "NORMAL";
   }
 
-  String msg;
-  serializeJson(doc, msg);
-  ws.textAll(msg);
+  unsigned long now = millis();
+  bool keyframe =
+      !havePublished || now - lastKeyframeMs >= WS_KEYFRAME_INTERVAL_MS;
+  if (!keyframe && cur == published)
+    return false; // nothing changed: no JSON, no heap, no airtime
+
+  const Snapshot *prev = keyframe ? nullptr : &published;
+  if (!sendFrame(ws, [&](char *buf, size_t size) {
+        return LivePayload::writeFrame(buf, size, cur, prev);
+      }))
+    return false; // out of heap: the next tick sends the change
+
+  published = cur;
+  havePublished = true;
+  if (keyframe)
+    lastKeyframeMs = now;
+  return true;
+}
+
+void WebHandler::broadcastHistoryAppend(AsyncWebSocket &ws,
+                                        const StorageMgr::Reading &r,
+                                        uint32_t seq) {
+  if (ws.count() == 0)
+    return;
+
+  sendFrame(ws, [&](char *buf, size_t size) {
+    return LivePayload::writeHistoryAppend(buf, size, r, seq);
+  });
 }
 
 void WebHandler::cleanupClients(AsyncWebSocket &ws) { ws.cleanupClients(); }
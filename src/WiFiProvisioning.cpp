@@ -1,5 +1,6 @@
 #include "WiFiProvisioning.h"
 #include "Config.h"
+#include "SettingsManager.h"
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <DNSServer.h>
@@ -161,6 +162,8 @@ void WiFiProv::startProvisioningPortal() {
         river.trim();
 
         if (ssid.length() > 0) {
+            // Pending settings first, so the names entered here win
+            SettingsMgr::flush();
             prefs.begin("wifi", false);
             prefs.putString("ssid", ssid);
             prefs.putString("pass", pass);
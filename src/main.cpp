@@ -1,60 +1,83 @@
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <ESPAsyncWebServer.h>
+#include <assert.h>
 #include <time.h>
 
 #include "Config.h"
-#include <Preferences.h>
 
 #include "CloudSync.h"
+#include "ConnectionPool.h"
+#include "Metrics.h"
 #include "NotificationManager.h"
+#include "OutboxManager.h"
+#include "PowerManager.h"
+#include "SamplingManager.h"
+#include "Scheduler.h"
 #include "SensorManager.h"
+#include "SettingsManager.h"
 #include "StorageManager.h"
 #include "WeatherService.h"
 #include "WebHandler.h"
 #include "WiFiProvisioning.h"
 
-static Preferences settings;
-
 // ─── Globals ────────────────────────────────────────────────────────────────
 AsyncWebServer server(80);
 AsyncWebSocket ws("/ws");
 
 float currentDistance = -1.0f;
-float warningThreshold = DEFAULT_WARNING_CM;
-float alarmThreshold = DEFAULT_ALARM_CM;
 bool buzzerActive = false;
 
-// ─── Manual Sync Control ────────────────────────────────────────────────────
-bool volatile pendingManualSync = false;
+// ─── Scheduled Tasks ────────────────────────────────────────────────────────
+// Registered in setup(); event tasks are started with Scheduler::trigger().
+static Scheduler::TaskId sensorTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId readingTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId syncTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId migrationTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId pollTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId cloudTask = Scheduler::INVALID_TASK;
+static Scheduler::TaskId notifyTask = Scheduler::INVALID_TASK;
 
-void triggerManualSync() { pendingManualSync = true; }
+// ─── Manual Sync Control ────────────────────────────────────────────────────
+void triggerManualSync() { Scheduler::trigger(syncTask); }
 
 // ─── Deferred Migration Control ─────────────────────────────────────────────
-bool volatile pendingMigration = false;
 String migOldStation = "";
 String migNewStation = "";
 String migRiver = "";
 
+void queueMigration(const String &oldName, const String &newName,
+                    const String &river) {
+  migOldStation = oldName;
+  migNewStation = newName;
+  migRiver = river;
+  Scheduler::trigger(migrationTask);
+}
+
 // ─── Timing & Intervals ──────────────────────────────────────────────────────
-unsigned long lastSensorRead = 0;
-unsigned long lastLogTime = 0;
-unsigned long lastWeatherPoll = 0;
-unsigned long lastWSBroadcast = 0;
-unsigned long lastNotificationTime = 0;
 uint32_t currentIntervalMs = SENSOR_READ_INTERVAL_MS;
 
+static void applyInterval(uint32_t ms) {
+  if (ms == currentIntervalMs)
+    return;
+  currentIntervalMs = ms;
+  Scheduler::setPeriod(sensorTask, currentIntervalMs);
+}
+
+/// The cloud's nextInterval caps the adaptive rate; it is reached while the
+/// level is calm (or always, with SAMPLE_ADAPTIVE off).
 void setMeasurementInterval(uint32_t seconds) {
   if (seconds >= 30) { // Safety floor: 30s
-    currentIntervalMs = seconds * 1000UL;
-    Serial.printf("[Interval] Set to %d s\n", seconds);
+    SamplingMgr::setCeilingMs(seconds * 1000UL);
+    Serial.printf("[Interval] Ceiling set to %d s\n", seconds);
+    if (!SAMPLE_ADAPTIVE)
+      applyInterval(seconds * 1000UL);
   }
 }
 
 // ─── Simulation ─────────────────────────────────────────────────────────────
 bool simulationActive = false;
 float simulatedDistance = 100.0f;
-unsigned long lastAutoSimUpdate = 0;
 bool autoSimEnabled = false;
 
 void setAutoSimulation(bool enabled) { autoSimEnabled = enabled; }
@@ -85,24 +108,341 @@ void initNTP() {
   Serial.printf("\n[NTP] Epoch: %lu\n", getEpoch());
 }
 
+// ─── Cloud Config ───────────────────────────────────────────────────────────
+/// Apply the leader's interval/thresholds from a completed cloud push.
+static void onCloudConfig(const CloudSync::CloudConfig &config) {
+  if (!config.success)
+    return;
+
+  if (config.nextIntervalS >= 30) {
+    setMeasurementInterval(config.nextIntervalS);
+  }
+  // Persisted by SettingsMgr with a debounced write-back
+  if (config.warningThreshold > 0 &&
+      SettingsMgr::setWarningThreshold(config.warningThreshold)) {
+    Serial.printf("[Cloud] Synced Warn from leader: %s cm\n",
+                  String(config.warningThreshold, 1).c_str());
+  }
+  if (config.alarmThreshold > 0 &&
+      SettingsMgr::setAlarmThreshold(config.alarmThreshold)) {
+    Serial.printf("[Cloud] Synced Alarm from leader: %s cm\n",
+                  String(config.alarmThreshold, 1).c_str());
+  }
+  Serial.println("[Cloud] Sync successful");
+}
+
+/// A new threshold applies at once: take a fresh sample, so the buzzer,
+/// status frame and sampling interval don't wait out a long interval.
+static void onSettingsChange(SettingsMgr::Key key) {
+  if (key == SettingsMgr::WARNING_CM || key == SettingsMgr::ALARM_CM)
+    Scheduler::trigger(sensorTask);
+}
+
+// ─── Reading Handling (alarm fast path) ────────────────────────────────────
+static uint32_t sampleUs = 0; // micros() when `currentDistance` was captured
+static const char *lastStatus = "NORMAL";
+
+/// Evaluate thresholds for the latest `currentDistance`. Local outputs come
+/// first: the buzzer, then an immediate WebSocket frame on a status change.
+/// Telegram and the cloud push are only queued here and go out later from
+/// lower-priority tasks.
+static void handleReading(unsigned long now) {
+  Metrics::Scope timer(Metrics::READING);
+
+  // Update thresholds and buzzer
+  float baseWarn = SettingsMgr::warningThreshold();
+  float baseAlarm = SettingsMgr::alarmThreshold();
+
+  float activeWarn = baseWarn;
+  float activeAlarm = baseAlarm;
+
+  if (WeatherSvc::isRainExpected()) {
+    activeWarn *= RAIN_THRESHOLD_FACTOR;
+    activeAlarm *= RAIN_THRESHOLD_FACTOR;
+  }
+
+  const char *statusStr = "NORMAL";
+  if (currentDistance > 0) {
+    if (currentDistance <= activeAlarm) {
+      statusStr = "ALARM";
+      digitalWrite(PIN_BUZZER, HIGH);
+      buzzerActive = true;
+    } else if (currentDistance <= activeWarn) {
+      statusStr = "WARNING";
+      digitalWrite(PIN_BUZZER, (now / 500) % 2); // Blink buzzer
+      buzzerActive = false;
+    } else {
+      digitalWrite(PIN_BUZZER, LOW);
+      buzzerActive = false;
+    }
+  }
+
+  Metrics::recordLatency(Metrics::SAMPLE_TO_BUZZER, micros() - sampleUs);
+
+  if (currentDistance > 0) {
+    applyInterval(SamplingMgr::update(now, currentDistance, activeWarn,
+                                      activeAlarm,
+                                      WeatherSvc::isRainExpected()));
+  }
+
+  // ── Status transition: tell local clients now, not at the next tick ──
+  if (strcmp(statusStr, lastStatus) != 0) {
+    if (WebHandler::broadcastLevel(ws, currentDistance, baseWarn, baseAlarm,
+                                   WeatherSvc::isRainExpected(),
+                                   WeatherSvc::getForecastDescription())) {
+      uint32_t wsUs = micros() - sampleUs;
+      Metrics::recordLatency(Metrics::SAMPLE_TO_WS, wsUs);
+      Serial.printf("[Alarm] %s -> %s (frame queued %lu us after sample)\n",
+                    lastStatus, statusStr, (unsigned long)wsUs);
+    } else {
+      Serial.printf("[Alarm] %s -> %s\n", lastStatus, statusStr);
+    }
+    lastStatus = statusStr;
+  }
+
+  // ── Outbound work, queued behind the local outputs ──────────────────
+  if (strcmp(statusStr, "ALARM") == 0)
+    NotificationMgr::reportAlarm(currentDistance); // coalesced per cooldown
+  PowerMgr::noteSample(strcmp(statusStr, "NORMAL") != 0);
+
+  // Cloud Push (Every sensor read, result arrives in onCloudConfig)
+  CloudSync::requestPush(currentDistance, baseWarn, baseAlarm, statusStr);
+}
+
+/// Push each logged reading to dashboards so they don't refetch the history.
+static void onHistoryAppend(const StorageMgr::Reading &r, uint32_t seq) {
+  WebHandler::broadcastHistoryAppend(ws, r, seq);
+}
+
+// ─── Tasks ──────────────────────────────────────────────────────────────────
+
+static void autoSimTask(unsigned long /*now*/) {
+  if (!autoSimEnabled)
+    return;
+  simulationActive = true;
+  simulatedDistance = 20.0f + (random(0, 1800) / 10.0f); // 20.0cm to 200.0cm
+  Serial.printf("[AutoSim] Next distance: %.1f cm\n", simulatedDistance);
+  triggerManualSync(); // Ensure the 1-minute auto-cycle value is pushed
+                       // immediately
+}
+
+static void sensorReadTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::SENSOR);
+  if (simulationActive) {
+    if (simulatedDistance > 0)
+      currentDistance = simulatedDistance;
+    sampleUs = micros();
+    Scheduler::trigger(readingTask);
+  } else if (SENSOR_ASYNC_CAPTURE) {
+    SensorMgr::requestReading(); // completes in sensorPollTask
+  } else {
+    float dist = SensorMgr::readDistanceCm();
+    if (dist > 0) {
+      currentDistance = dist;
+    }
+    sampleUs = SensorMgr::lastSampleUs();
+    Scheduler::trigger(readingTask);
+  }
+}
+
+/// Collect the async sensor burst (never blocks). Armed by SensorMgr when
+/// a burst starts and re-armed only until it completes.
+static void sensorPollTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::SENSOR_POLL);
+  float polledDist;
+  if (SensorMgr::poll(polledDist)) {
+    if (polledDist > 0 && !simulationActive) {
+      currentDistance = polledDist;
+    }
+    sampleUs = SensorMgr::lastSampleUs();
+    Scheduler::trigger(readingTask);
+  }
+  if (SensorMgr::isBusy())
+    Scheduler::triggerIn(pollTask, SCHED_SENSOR_POLL_MS);
+}
+
+static void startPolling() { Scheduler::trigger(pollTask); }
+
+static void readingTaskFn(unsigned long now) { handleReading(now); }
+
+static void broadcastTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::WEBSOCKET);
+  WebHandler::broadcastLevel(ws, currentDistance,
+                             SettingsMgr::warningThreshold(),
+                             SettingsMgr::alarmThreshold(),
+                             WeatherSvc::isRainExpected(),
+                             WeatherSvc::getForecastDescription());
+  WebHandler::cleanupClients(ws);
+}
+
+static void logTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::LOG);
+  if (currentDistance > 0) {
+    unsigned long epoch = getEpoch();
+    StorageMgr::logReading(epoch, currentDistance);
+  }
+}
+
+static void weatherTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::WEATHER);
+  WeatherSvc::update();
+  // A new rain forecast shouldn't wait out a long calm-weather interval
+  if (SAMPLE_ADAPTIVE && WeatherSvc::isRainExpected() &&
+      currentIntervalMs > SAMPLE_RAIN_INTERVAL_MS)
+    applyInterval(SAMPLE_RAIN_INTERVAL_MS);
+}
+
+static void manualSyncTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::MANUAL_SYNC);
+  Serial.println("[Main] Processing Manual Sync...");
+
+  const char *statusStr = "NORMAL";
+  float activeWarn = SettingsMgr::warningThreshold();
+  float activeAlarm = SettingsMgr::alarmThreshold();
+  if (WeatherSvc::isRainExpected()) {
+    activeWarn *= RAIN_THRESHOLD_FACTOR;
+    activeAlarm *= RAIN_THRESHOLD_FACTOR;
+  }
+  if (currentDistance > 0) {
+    if (currentDistance <= activeAlarm)
+      statusStr = "ALARM";
+    else if (currentDistance <= activeWarn)
+      statusStr = "WARNING";
+  }
+
+  CloudSync::requestPush(currentDistance, SettingsMgr::warningThreshold(),
+                         SettingsMgr::alarmThreshold(), statusStr, true);
+}
+
+static void migrationTaskFn(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::MIGRATION);
+  Serial.printf("[Main] Processing Migration: %s -> %s (%s)...\n",
+                migOldStation.c_str(), migNewStation.c_str(), migRiver.c_str());
+
+  CloudSync::requestMigration(migOldStation, migNewStation, migRiver);
+}
+
+/// Re-arm a network event task for its next step, or leave it asleep.
+static void armNetTask(Scheduler::TaskId id, int32_t waitMs) {
+  if (waitMs >= 0)
+    Scheduler::triggerIn(id, waitMs > (int32_t)SCHED_CLOUD_STEP_MS
+                                 ? (uint32_t)waitMs
+                                 : SCHED_CLOUD_STEP_MS);
+}
+
+/// Cloud uplink: advances one step per run, never waits. Only armed while
+/// CloudSync has something pending.
+static void cloudTaskFn(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::CLOUD);
+  CloudSync::loop();
+  armNetTask(cloudTask, CloudSync::nextStepMs());
+}
+
+static void wakeCloud() { Scheduler::trigger(cloudTask); }
+
+static void poolTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::POOL);
+  ConnPool::loop();
+}
+
+/// Debounced Preferences write-back.
+static void settingsTask(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::SETTINGS);
+  SettingsMgr::loop();
+}
+
+/// Telegram send queue; one network step per run, like the cloud task.
+static void notifyTaskFn(unsigned long /*now*/) {
+  Metrics::Scope timer(Metrics::NOTIFY);
+  NotificationMgr::loop();
+  armNetTask(notifyTask, NotificationMgr::nextStepMs());
+}
+
+static void wakeNotify() { Scheduler::trigger(notifyTask); }
+
+/// Radio duty cycle / deep sleep once uploads are done (LOW_POWER_MODE).
+static void powerTask(unsigned long /*now*/) { PowerMgr::loop(); }
+
+static void heapTask(unsigned long /*now*/) { Metrics::sampleHeap(); }
+
+static void heartbeatTask(unsigned long now) {
+  Serial.print("[Heartbeat] System uptime: ");
+  Serial.print(now / 1000);
+  Serial.println("s");
+}
+
+/// Register a task. Running out of scheduler slots is a programming error:
+/// SCHED_MAX_TASKS must be raised along with the task list.
+static Scheduler::TaskId addTask(const char *name, Scheduler::TaskFn fn,
+                                 uint32_t periodMs,
+                                 Scheduler::Priority priority,
+                                 uint32_t deadlineMs = 0) {
+  Scheduler::TaskId id = Scheduler::add(name, fn, periodMs, priority,
+                                        deadlineMs);
+  if (id == Scheduler::INVALID_TASK) {
+    Serial.printf("[Main] FATAL: task %s not registered, raise "
+                  "SCHED_MAX_TASKS\n",
+                  name);
+    assert(id != Scheduler::INVALID_TASK);
+  }
+  return id;
+}
+
+/// Alarm evaluation outranks everything; network work runs last. Sensor
+/// polling and the network queues are event tasks that stay armed only
+/// while they have work, so idle() can sleep between samples.
+static void registerTasks() {
+  using namespace Scheduler;
+  readingTask = addTask("reading", readingTaskFn, 0, PRIO_ALARM, 50);
+  sensorTask =
+      addTask("sensor", sensorReadTask, currentIntervalMs, PRIO_HIGH, 100);
+  pollTask = addTask("sensor_poll", sensorPollTask, 0, PRIO_HIGH, 20);
+  addTask("auto_sim", autoSimTask, 60000UL, PRIO_NORMAL);
+  addTask("websocket", broadcastTask, WS_BROADCAST_INTERVAL_MS, PRIO_NORMAL,
+          1000);
+  addTask("log", logTask, LOG_INTERVAL_MS, PRIO_NORMAL, 5000);
+  syncTask = addTask("manual_sync", manualSyncTask, 0, PRIO_NORMAL, 1000);
+  migrationTask = addTask("migration", migrationTaskFn, 0, PRIO_LOW);
+  notifyTask = addTask("notify", notifyTaskFn, 0, PRIO_LOW);
+  cloudTask = addTask("cloud", cloudTaskFn, 0, PRIO_LOW);
+  addTask("pool", poolTask, 1000, PRIO_LOW);
+  addTask("settings", settingsTask, 500, PRIO_LOW);
+  addTask("weather", weatherTask, WEATHER_POLL_INTERVAL_MS, PRIO_LOW);
+  addTask("power", powerTask, 1000, PRIO_LOW);
+  addTask("heap", heapTask, METRICS_HEAP_SAMPLE_MS, PRIO_LOW);
+  addTask("heartbeat", heartbeatTask, 5000, PRIO_LOW);
+
+  SensorMgr::onBurstStart(startPolling);
+  CloudSync::onWake(wakeCloud);
+  NotificationMgr::onWake(wakeNotify);
+  // Readings restored from flash are pending before anything is queued
+  wakeCloud();
+}
+
 // ─── Setup ──────────────────────────────────────────────────────────────────
 void setup() {
   Serial.begin(115200);
+  // Deep-sleep timer wakes sample and go back to sleep in here
+  PowerMgr::begin();
+
   // CRITICAL: ESP32-C3 can take time to start the USB port
-  for (int i = 5; i > 0; i--) {
+  for (int i = 5; i > 0 && !PowerMgr::wokeFromSleep(); i--) {
     delay(1000);
     Serial.printf("[DEBUG] Starting in %d...\n", i);
   }
 
   Serial.println("\n[BOOT] VERIFIED: Serial communication is working!");
 
-  // Buzzer pin
+  // Buzzer pin. On an alarm wake it sounds now, before WiFi, and follows
+  // the live status from the first reading on.
   pinMode(PIN_BUZZER, OUTPUT);
-  digitalWrite(PIN_BUZZER, LOW);
+  digitalWrite(PIN_BUZZER, PowerMgr::alarmWake() ? HIGH : LOW);
 
   // Init sensor + storage
   SensorMgr::begin();
   StorageMgr::begin();
+  OutboxMgr::begin();
+  PowerMgr::flushRtcBuffer(); // readings from deep-sleep wakes
 
   // WiFi: honor WIFI_FORCE_CONFIG Choice
   bool connected = false;
@@ -121,12 +461,19 @@ void setup() {
     connected = (WiFi.status() == WL_CONNECTED);
   }
 
-  if (!connected && !WiFiProv::connectFromStored()) {
+  if (!connected)
+    connected = WiFiProv::connectFromStored();
+  // On battery: sleep rather than block in the portal, unless the level is
+  // high; then run offline
+  bool offline = !connected && PowerMgr::retryLater();
+  if (!connected && !offline) {
     if (WIFI_FORCE_CONFIG) {
       Serial.println(
           "[Main] WiFi connection failed. AP Mode is DISABLED via Config.h");
       Serial.println("[Main] Retrying in 30 seconds...");
       delay(30000);
+      OutboxMgr::checkpoint();
+      SettingsMgr::flush();
       ESP.restart();
     } else {
       Serial.println("[Main] No WiFi — starting provisioning portal.");
@@ -137,8 +484,11 @@ void setup() {
     }
   }
 
-  // At this point WiFi is connected
-  Serial.println("[Main] WiFi connected. IP: " + WiFiProv::getLocalIP());
+  // At this point WiFi is connected, or the station runs offline
+  if (offline)
+    Serial.println("[Main] Running offline: level past a threshold.");
+  else
+    Serial.println("[Main] WiFi connected. IP: " + WiFiProv::getLocalIP());
 
   // NTP
   initNTP();
@@ -147,13 +497,15 @@ void setup() {
   WeatherSvc::begin(OWM_API_KEY, OWM_CITY, OWM_COUNTRY);
   WeatherSvc::update(); // initial fetch
 
-  // Load thresholds from preferences
-  settings.begin("flood", false);
-  warningThreshold = settings.getFloat("warn", DEFAULT_WARNING_CM);
-  alarmThreshold = settings.getFloat("alarm", DEFAULT_ALARM_CM);
-  settings.end();
-  Serial.printf("[Main] Loaded Thresholds: Warn=%.1f, Alarm=%.1f\n",
-                warningThreshold, alarmThreshold);
+  // Load thresholds + station metadata once; hot paths read them from RAM
+  SettingsMgr::begin();
+
+  SettingsMgr::onChange(onSettingsChange);
+  CloudSync::onConfig(onCloudConfig);
+  PowerMgr::onRadioUp(triggerManualSync);
+  StorageMgr::onAppend(onHistoryAppend);
+
+  registerTasks();
 
   // Web server
   WebHandler::begin(server, ws);
@@ -167,201 +519,10 @@ void setup() {
 
 // ─── Loop ───────────────────────────────────────────────────────────────────
 void loop() {
-  unsigned long now = millis();
-
-  // ── Auto-Simulation ────────────────────────────────────────────────
-  if (autoSimEnabled && (now - lastAutoSimUpdate >= 60000UL)) {
-    lastAutoSimUpdate = now;
-    simulationActive = true;
-    simulatedDistance = 20.0f + (random(0, 1800) / 10.0f); // 20.0cm to 200.0cm
-    Serial.printf("[AutoSim] Next distance: %.1f cm\n", simulatedDistance);
-    triggerManualSync(); // Ensure the 1-minute auto-cycle value is pushed
-                         // immediately
-  }
-
-  // ── Read sensor ─────────────────────────────────────────────────────
-
-  // ── Read sensor ─────────────────────────────────────────────────────
-  if (now - lastSensorRead >= currentIntervalMs) {
-    lastSensorRead = now;
-
-    if (simulationActive) {
-      if (simulatedDistance > 0)
-        currentDistance = simulatedDistance;
-    } else {
-      float dist = SensorMgr::readDistanceCm();
-      if (dist > 0) {
-        currentDistance = dist;
-      }
-    }
-
-    // Update thresholds and buzzer
-    float baseWarn = warningThreshold;
-    float baseAlarm = alarmThreshold;
-
-    float activeWarn = baseWarn;
-    float activeAlarm = baseAlarm;
-
-    if (WeatherSvc::isRainExpected()) {
-      activeWarn *= RAIN_THRESHOLD_FACTOR;
-      activeAlarm *= RAIN_THRESHOLD_FACTOR;
-    }
-
-    String statusStr = "NORMAL";
-    if (currentDistance > 0) {
-      if (currentDistance <= activeAlarm) {
-        statusStr = "ALARM";
-        digitalWrite(PIN_BUZZER, HIGH);
-        buzzerActive = true;
-        if (now - lastNotificationTime >= (TELEGRAM_COOLDOWN_MIN * 60000UL) ||
-            lastNotificationTime == 0) {
-          lastNotificationTime = now;
-          NotificationMgr::sendTelegram(
-              "🚨 FLOOD ALARM! Water: " + String(currentDistance) + " cm");
-        }
-      } else if (currentDistance <= activeWarn) {
-        statusStr = "WARNING";
-        digitalWrite(PIN_BUZZER, (now / 500) % 2); // Blink buzzer
-        buzzerActive = false;
-      } else {
-        digitalWrite(PIN_BUZZER, LOW);
-        buzzerActive = false;
-      }
-    }
-
-    // ── Cloud Push (Every sensor read) ──────────────────────────────
-    CloudSync::CloudConfig config =
-        CloudSync::pushData(currentDistance, baseWarn, baseAlarm, statusStr);
-
-    if (config.success) {
-      if (config.nextIntervalS >= 30) {
-        setMeasurementInterval(config.nextIntervalS);
-      }
-      if (config.warningThreshold > 0) {
-        if (warningThreshold != config.warningThreshold) {
-          warningThreshold = config.warningThreshold;
-          Serial.printf("[Cloud] Synced Warn from leader: %s cm\n",
-                        String(warningThreshold, 1).c_str());
-          settings.begin("flood", false);
-          settings.putFloat("warn", warningThreshold);
-          settings.end();
-        }
-      }
-      if (config.alarmThreshold > 0) {
-        if (alarmThreshold != config.alarmThreshold) {
-          alarmThreshold = config.alarmThreshold;
-          Serial.printf("[Cloud] Synced Alarm from leader: %s cm\n",
-                        String(alarmThreshold, 1).c_str());
-          settings.begin("flood", false);
-          settings.putFloat("alarm", alarmThreshold);
-          settings.end();
-        }
-      }
-      Serial.println("[Cloud] Sync successful");
-    }
-  }
-
-  // ── Broadcast via WebSocket (Frequent updates) ──────────────────────
-  if (now - lastWSBroadcast >= WS_BROADCAST_INTERVAL_MS) {
-    lastWSBroadcast = now;
-    String curStatus = "NORMAL";
-    if (currentDistance <= alarmThreshold)
-      curStatus = "ALARM";
-    else if (currentDistance <= warningThreshold)
-      curStatus = "WARNING";
-
-    WebHandler::broadcastLevel(ws, currentDistance, warningThreshold,
-                               alarmThreshold, WeatherSvc::isRainExpected(),
-                               WeatherSvc::getForecastDescription());
-    WebHandler::cleanupClients(ws);
-  }
-
-  // ── Log to CSV ──────────────────────────────────────────────────────
-  if (now - lastLogTime >= LOG_INTERVAL_MS) {
-    lastLogTime = now;
-    if (currentDistance > 0) {
-      unsigned long epoch = getEpoch();
-      StorageMgr::logReading(epoch, currentDistance);
-    }
+  uint32_t startUs = micros();
+  if (Scheduler::runNext()) {
+    Metrics::record(Metrics::LOOP, micros() - startUs);
+    return;
   }
-
-  // ── Poll weather ────────────────────────────────────────────────────
-  if (now - lastWeatherPoll >= WEATHER_POLL_INTERVAL_MS) {
-    lastWeatherPoll = now;
-    WeatherSvc::update();
-  }
-
-  // ── Manual Sync Check (Main Loop Only) ──────────────────────────────
-  if (pendingManualSync) {
-    pendingManualSync = false;
-    Serial.println("[Main] Processing Manual Sync...");
-
-    String statusStr = "NORMAL";
-    float activeWarn = warningThreshold;
-    float activeAlarm = alarmThreshold;
-    if (WeatherSvc::isRainExpected()) {
-      activeWarn *= RAIN_THRESHOLD_FACTOR;
-      activeAlarm *= RAIN_THRESHOLD_FACTOR;
-    }
-    if (currentDistance > 0) {
-      if (currentDistance <= activeAlarm)
-        statusStr = "ALARM";
-      else if (currentDistance <= activeWarn)
-        statusStr = "WARNING";
-    }
-
-    CloudSync::CloudConfig config = CloudSync::pushData(
-        currentDistance, warningThreshold, alarmThreshold, statusStr);
-
-    if (config.success) {
-      if (config.nextIntervalS >= 30)
-        setMeasurementInterval(config.nextIntervalS);
-      if (config.warningThreshold > 0 &&
-          warningThreshold != config.warningThreshold) {
-        warningThreshold = config.warningThreshold;
-        Serial.printf("[Cloud] Manual Sync - Synced Warn from leader: %s cm\n",
-                      String(warningThreshold, 1).c_str());
-        settings.begin("flood", false);
-        settings.putFloat("warn", warningThreshold);
-        settings.end();
-      }
-      if (config.alarmThreshold > 0 &&
-          alarmThreshold != config.alarmThreshold) {
-        alarmThreshold = config.alarmThreshold;
-        Serial.printf("[Cloud] Manual Sync - Synced Alarm from leader: %s cm\n",
-                      String(alarmThreshold, 1).c_str());
-        settings.begin("flood", false);
-        settings.putFloat("alarm", alarmThreshold);
-        settings.end();
-      }
-      Serial.println("[Cloud] Manual Sync Success");
-    }
-  }
-
-  // ── Deferred Migration Check ────────────────────────────────────────
-  if (pendingMigration) {
-    pendingMigration = false;
-    Serial.printf("[Main] Processing Migration: %s -> %s (%s)...\n",
-                  migOldStation.c_str(), migNewStation.c_str(),
-                  migRiver.c_str());
-
-    bool success =
-        CloudSync::migrateStation(migOldStation, migNewStation, migRiver);
-    if (success) {
-      Serial.println("[Main] Migration successful in cloud.");
-    } else {
-      Serial.println("[Main] Migration failed or not needed.");
-    }
-  }
-
-  // ── Heartbeat ──────────────────────────────────────────────────────
-  static unsigned long lastHeartbeat = 0;
-  if (now - lastHeartbeat >= 5000) {
-    lastHeartbeat = now;
-    Serial.print("[Heartbeat] System uptime: ");
-    Serial.print(now / 1000);
-    Serial.println("s");
-  }
-
-  delay(10); // yield
+  Scheduler::idle(); // nothing due: sleep until the next task is
 }